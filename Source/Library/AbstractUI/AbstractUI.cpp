@@ -237,21 +237,52 @@ bool AbstractCollapsiblePanel::SetBody(AbstractWidget* body)
 //////////////////////////////////////////////////////////////////////////
 void AbstractHierarchyListItem::InsertChild(AbstractHierarchyListItem* item, unsigned index)
 {
+    index = Min(index, children_.Size());
     children_.Insert(index, SharedPtr<AbstractHierarchyListItem>(item));
     item->SetParent(this);
+    item->index_ = index;
+
+    // Children after inserted one are shifted
+    if (index + 1 < children_.Size())
+        InvalidateIndices(index);
 }
 
 void AbstractHierarchyListItem::RemoveChild(unsigned index)
 {
+    if (index >= children_.Size())
+        return;
+
+    children_[index]->SetParent(nullptr);
     children_.Erase(index);
+
+    // Children after removed one are shifted
+    if (index < children_.Size())
+        InvalidateIndices(index);
 }
 
 int AbstractHierarchyListItem::FindChild(const AbstractHierarchyListItem* child) const
 {
-    for (unsigned i = 0; i < children_.Size(); ++i)
-        if (children_[i] == child)
-            return static_cast<int>(i);
-    return -1;
+    if (!child || child->parent_ != this)
+        return -1;
+    return child->GetIndex();
+}
+
+int AbstractHierarchyListItem::GetIndex() const
+{
+    if (!parent_)
+        return 0;
+
+    // Renumber lazily, indices before the first outdated one are always valid
+    if (index_ >= parent_->firstInvalidIndex_)
+        parent_->UpdateIndices();
+    return static_cast<int>(index_);
+}
+
+void AbstractHierarchyListItem::UpdateIndices() const
+{
+    for (unsigned i = firstInvalidIndex_; i < children_.Size(); ++i)
+        children_[i]->index_ = i;
+    firstInvalidIndex_ = M_MAX_UNSIGNED;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -13,6 +13,7 @@ namespace Urho3D
 class Scene;
 class Node;
 class Camera;
+class Image;
 class Serializable;
 
 class AbstractMainWindow;
@@ -330,13 +331,30 @@ public:
     unsigned GetNumChildren() const { return children_.Size(); }
     AbstractHierarchyListItem* GetChild(unsigned index) const { return index < children_.Size() ? children_[index] : nullptr; }
     int FindChild(const AbstractHierarchyListItem* child) const;
-    int GetIndex() const { return parent_ ? parent_->FindChild(this) : 0; }
+    int GetIndex() const;
+    /// Set whether the children of the item are shown.
+    void SetExpanded(bool expanded) { expanded_ = expanded; }
+    /// Return whether the children of the item are shown.
+    bool IsExpanded() const { return expanded_; }
 
     virtual String GetText() { return String::EMPTY; }
+    /// Return image shown next to text. Image shall have 4 components.
+    virtual Image* GetImage() { return nullptr; }
+
+private:
+    /// Mark cached indices of children starting from given one as outdated.
+    void InvalidateIndices(unsigned firstIndex) { firstInvalidIndex_ = Min(firstInvalidIndex_, firstIndex); }
+    /// Update outdated cached indices of children.
+    void UpdateIndices() const;
 
 private:
     AbstractHierarchyListItem* parent_ = nullptr;
     Vector<SharedPtr<AbstractHierarchyListItem>> children_;
+    bool expanded_ = false;
+    /// Cached index of the item in the parent.
+    mutable unsigned index_ = 0;
+    /// First child with outdated cached index.
+    mutable unsigned firstInvalidIndex_ = M_MAX_UNSIGNED;
 };
 
 class AbstractHierarchyList : public AbstractWidget
@@ -352,13 +370,21 @@ public:
     virtual void RemoveAllItems() = 0;
     virtual void SelectItem(AbstractHierarchyListItem* item) = 0;
     virtual void DeselectItem(AbstractHierarchyListItem* item) = 0;
+    /// Replace selection with given items at once.
+    virtual void SetSelection(const ItemVector& items) = 0;
     virtual void ExpandItem(AbstractHierarchyListItem* item) = 0;
     virtual void GetSelection(ItemVector& result) = 0;
     ItemVector GetSelection() { ItemVector result; GetSelection(result); return result; }
+    /// Set whether more top-level items may be added on demand. Reset when all items are removed.
+    virtual void SetHasMoreItems(bool hasMoreItems) = 0;
+    /// Update shown text and image of the item.
+    virtual void UpdateItem(AbstractHierarchyListItem* item) = 0;
 
 public:
     std::function<void(AbstractHierarchyListItem* item)> onItemClicked_;
     std::function<void(AbstractHierarchyListItem* item)> onItemDoubleClicked_;
+    /// Called when the end of the list is shown and more items may be added.
+    std::function<void()> onMoreItemsRequested_;
 };
 
 class AbstractView3D : public AbstractWidget
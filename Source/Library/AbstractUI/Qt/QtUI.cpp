@@ -11,6 +11,7 @@
 #include <QScrollBar>
 #include <QPainter>
 #include <QResizeEvent>
+#include <algorithm>
 
 namespace Urho3D
 {
@@ -308,6 +309,7 @@ void QtWidgetStack::DoAddChild(QWidget* child)
 void QtWidgetStack::DoRemoveChild(QWidget* child)
 {
     stack_->removeWidget(child);
+    child->deleteLater();
 }
 
 void QtWidgetStack::DoSelectChild(QWidget* child)
@@ -408,7 +410,7 @@ void QtHierarchyListModel::InsertItem(AbstractHierarchyListItem* item, const QMo
     const int numChildren = static_cast<int>(parentItem->GetNumChildren());
     row = Clamp(row, 0, numChildren);
 
-    beginInsertRows(QModelIndex(), row, row);
+    beginInsertRows(parentIndex, row, row);
     parentItem->InsertChild(item, static_cast<unsigned>(row));
     endInsertRows();
 }
@@ -457,6 +459,16 @@ QVariant QtHierarchyListModel::data(const QModelIndex& index, int role) const
     {
     case Qt::DisplayRole:
         return Cast(item->GetText());
+    case Qt::DecorationRole:
+        if (Image* image = item->GetImage())
+        {
+            if (image->GetComponents() == 4)
+            {
+                const int width = image->GetWidth();
+                return QImage(image->GetData(), width, image->GetHeight(), width * 4, QImage::Format_RGBA8888).copy();
+            }
+        }
+        return QVariant();
 //     case Qt::TextColorRole:
 //         return spec_.GetObjectColor(item->GetObject());
     default:
@@ -490,7 +502,7 @@ QModelIndex QtHierarchyListModel::parent(const QModelIndex& index) const
     AbstractHierarchyListItem* childItem = GetItem(index);
     AbstractHierarchyListItem* parentItem = static_cast<AbstractHierarchyListItem*>(childItem->GetParent());
 
-    if (childItem == &rootItem_)
+    if (!parentItem || parentItem == &rootItem_)
         return QModelIndex();
 
     return createIndex(parentItem->GetIndex(), 0, parentItem);
@@ -503,16 +515,26 @@ int QtHierarchyListModel::rowCount(const QModelIndex& parent /*= QModelIndex()*/
     return parentItem->GetNumChildren();
 }
 
+bool QtHierarchyListModel::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && hasMoreItems_;
+}
+
+void QtHierarchyListModel::fetchMore(const QModelIndex& parent)
+{
+    if (!parent.isValid() && hasMoreItems_ && onFetchMore_)
+        onFetchMore_();
+}
+
 //////////////////////////////////////////////////////////////////////////
 QtHierarchyList::QtHierarchyList(AbstractMainWindow* mainWindow)
     : AbstractHierarchyList(mainWindow)
     , treeView_(new QTreeView())
-    , model_(new QtHierarchyListModel(mainWindow_))
 {
     treeView_->header()->hide();
     treeView_->setDragDropMode(QAbstractItemView::DragDrop);
     treeView_->setDragEnabled(true);
-    treeView_->setModel(model_.data());
+    ResetModel();
 
     connect(treeView_, &QTreeView::clicked,
         [=](const QModelIndex& index)
@@ -560,8 +582,7 @@ void QtHierarchyList::RemoveItem(AbstractHierarchyListItem* item)
 void QtHierarchyList::RemoveAllItems()
 {
     // #TODO Reset more gracefully
-    model_.reset(new QtHierarchyListModel(mainWindow_));
-    treeView_->setModel(model_.data());
+    ResetModel();
 }
 
 void QtHierarchyList::SelectItem(AbstractHierarchyListItem* item)
@@ -583,6 +604,49 @@ void QtHierarchyList::DeselectItem(AbstractHierarchyListItem* item)
         selectionModel->select(itemIndex, QItemSelectionModel::Deselect);
 }
 
+void QtHierarchyList::SetSelection(const ItemVector& items)
+{
+    // Sort indices by parent and row
+    std::vector<QModelIndex> indices;
+    indices.reserve(items.Size());
+    for (AbstractHierarchyListItem* item : items)
+    {
+        const QModelIndex itemIndex = model_->GetIndex(item);
+        if (itemIndex.isValid())
+            indices.push_back(itemIndex);
+    }
+    std::sort(indices.begin(), indices.end(),
+        [](const QModelIndex& lhs, const QModelIndex& rhs)
+    {
+        const quintptr lhsParent = lhs.parent().internalId();
+        const quintptr rhsParent = rhs.parent().internalId();
+        return lhsParent != rhsParent ? lhsParent < rhsParent : lhs.row() < rhs.row();
+    });
+
+    // Merge adjacent rows into ranges
+    QItemSelection selection;
+    for (unsigned first = 0; first < indices.size(); )
+    {
+        const QModelIndex parentIndex = indices[first].parent();
+        unsigned last = first;
+        while (last + 1 < indices.size() && indices[last + 1].row() == indices[last].row() + 1
+            && indices[last + 1].parent() == parentIndex)
+            ++last;
+        selection.append(QItemSelectionRange(indices[first], indices[last]));
+        first = last + 1;
+    }
+
+    // Apply at once
+    QItemSelectionModel* selectionModel = treeView_->selectionModel();
+    selectionModel->select(selection, QItemSelectionModel::ClearAndSelect);
+    if (!items.Empty())
+    {
+        const QModelIndex lastIndex = model_->GetIndex(items.Back());
+        if (lastIndex.isValid())
+            treeView_->scrollTo(lastIndex);
+    }
+}
+
 void QtHierarchyList::ExpandItem(AbstractHierarchyListItem* item)
 {
     QModelIndex itemIndex = model_->GetIndex(item);
@@ -602,6 +666,29 @@ void QtHierarchyList::GetSelection(ItemVector& result)
             result.Push(item);
 }
 
+void QtHierarchyList::SetHasMoreItems(bool hasMoreItems)
+{
+    model_->SetHasMoreItems(hasMoreItems);
+}
+
+void QtHierarchyList::UpdateItem(AbstractHierarchyListItem* item)
+{
+    const QModelIndex itemIndex = model_->GetIndex(item);
+    if (itemIndex.isValid())
+        emit model_->dataChanged(itemIndex, itemIndex);
+}
+
+void QtHierarchyList::ResetModel()
+{
+    model_.reset(new QtHierarchyListModel(mainWindow_));
+    model_->onFetchMore_ = [=]()
+    {
+        if (onMoreItemsRequested_)
+            onMoreItemsRequested_();
+    };
+    treeView_->setModel(model_.data());
+}
+
 //////////////////////////////////////////////////////////////////////////
 QtUrhoRenderSurface::QtUrhoRenderSurface(Texture2D* renderTexture, Texture2D* depthTexture, Viewport* viewport, Image* image_,
     QWidget* parent /*= nullptr*/)
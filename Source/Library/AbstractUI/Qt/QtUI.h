@@ -233,6 +233,12 @@ public:
 
     QModelIndex GetIndex(AbstractHierarchyListItem* item, const QModelIndex& hint = QModelIndex());
     AbstractHierarchyListItem* GetItem(const QModelIndex& index) const;
+    /// Set whether more top-level items may be fetched.
+    void SetHasMoreItems(bool hasMoreItems) { hasMoreItems_ = hasMoreItems; }
+
+public:
+    /// Called when view fetches more top-level items.
+    std::function<void()> onFetchMore_;
 
 public:
     QVariant data(const QModelIndex& index, int role) const override;
@@ -241,9 +247,13 @@ public:
     QModelIndex parent(const QModelIndex& index) const override;
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
     int columnCount(const QModelIndex& parent = QModelIndex()) const override { return 1; }
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
 
 private:
     AbstractHierarchyListItem rootItem_;
+    /// Whether more top-level items may be fetched.
+    bool hasMoreItems_ = false;
 
 };
 
@@ -260,8 +270,15 @@ public:
     void RemoveAllItems() override;
     void SelectItem(AbstractHierarchyListItem* item) override;
     void DeselectItem(AbstractHierarchyListItem* item) override;
+    void SetSelection(const ItemVector& items) override;
     void ExpandItem(AbstractHierarchyListItem* item) override;
     void GetSelection(ItemVector& result) override;
+    void SetHasMoreItems(bool hasMoreItems) override;
+    void UpdateItem(AbstractHierarchyListItem* item) override;
+
+private:
+    /// Create empty model and attach it to the view.
+    void ResetModel();
 
 private:
 
@@ -1,11 +1,15 @@
 #include "UrhoUI.h"
 #include "GridLayout.h"
 #include <Urho3D/IO/Log.h>
+#include <Urho3D/Core/CoreEvents.h>
 #include <Urho3D/Graphics/Graphics.h>
 #include <Urho3D/Graphics/GraphicsEvents.h>
+#include <Urho3D/Graphics/Texture2D.h>
+#include <Urho3D/Resource/Image.h>
+#include <Urho3D/Input/InputEvents.h>
 #include <Urho3D/UI/UI.h>
 #include <Urho3D/UI/UIEvents.h>
-#include <Urho3D/UI/ListView.h>
+#include <Urho3D/UI/ScrollBar.h>
 #include <Urho3D/UI/DropDownList.h>
 #include <Urho3D/UI/CheckBox.h>
 #include <Urho3D/UI/Text.h>
@@ -30,16 +34,6 @@ void SetInternalElement(AbstractWidget* widget, UIElement* element)
     widget->SetInternalHandle(element);
 }
 
-UIElement* GetInternalElement(AbstractHierarchyListItem* item)
-{
-    return item ? item->GetInternalHandle<UIElement*>() : nullptr;
-}
-
-void SetInternalElement(AbstractHierarchyListItem* item, UIElement* element)
-{
-    item->SetInternalHandle(element);
-}
-
 UIElement* GetParentElement(AbstractWidget* widget)
 {
     return GetInternalElement(widget->GetParent());
@@ -609,124 +603,436 @@ void UrhoCheckBox::OnParentSet()
 //////////////////////////////////////////////////////////////////////////
 UrhoHierarchyList::UrhoHierarchyList(AbstractMainWindow* mainWindow)
     : AbstractHierarchyList(mainWindow)
+    , panel_(new UIElement(context_))
     , rootItem_(context_)
-    , hierarchyList_(new ListView(context_))
 {
-    hierarchyList_->SetName("AHL_HierarchyList");
-    SetInternalElement(this, hierarchyList_);
+    panel_->SetName("AHL_Panel");
+    SetInternalElement(this, panel_);
+    rootItem_.SetExpanded(true);
 }
 
 void UrhoHierarchyList::SetMultiselect(bool multiselect)
 {
-    hierarchyList_->SetMultiselect(multiselect);
+    multiselect_ = multiselect;
 }
 
 void UrhoHierarchyList::AddItem(AbstractHierarchyListItem* item, unsigned index, AbstractHierarchyListItem* parent)
 {
-    hierarchyList_->DisableInternalLayoutUpdate();
     if (parent)
         parent->InsertChild(item, index);
     else
+    {
         rootItem_.InsertChild(item, index);
-    InsertItem(item, index, parent);
-    hierarchyList_->EnableInternalLayoutUpdate();
-    hierarchyList_->UpdateInternalLayout();
+        item->SetExpanded(true);
+    }
+    MarkRowsDirty();
 }
 
 void UrhoHierarchyList::RemoveItem(AbstractHierarchyListItem* item)
 {
+    AbstractHierarchyListItem* parent = item ? item->GetParent() : nullptr;
+    if (!parent)
+        return;
 
+    const int index = parent->FindChild(item);
+    if (index < 0)
+        return;
+
+    DeselectChildren(item);
+    CompactSelectedItems();
+    parent->RemoveChild(static_cast<unsigned>(index));
+    MarkRowsDirty();
 }
 
 void UrhoHierarchyList::RemoveAllItems()
 {
-    hierarchyList_->RemoveAllItems();
+    while (rootItem_.GetNumChildren() > 0)
+        rootItem_.RemoveChild(rootItem_.GetNumChildren() - 1);
+    ClearSelectedItems();
+    firstRow_ = 0;
+    hasMoreItems_ = false;
+    MarkRowsDirty();
 }
 
 void UrhoHierarchyList::SelectItem(AbstractHierarchyListItem* item)
 {
-    if (auto itemWidget = GetInternalElement(item))
+    if (item && !selectedItems_.Contains(item))
     {
-        const unsigned index = hierarchyList_->FindItem(itemWidget);
-        if (!hierarchyList_->IsSelected(index))
-            hierarchyList_->ToggleSelection(index);
+        if (!multiselect_)
+            ClearSelectedItems();
+        InsertSelectedItem(item);
+        MarkWidgetsDirty();
     }
 }
 
 void UrhoHierarchyList::DeselectItem(AbstractHierarchyListItem* item)
 {
-    if (auto itemWidget = GetInternalElement(item))
+    if (EraseSelectedItem(item))
+        MarkWidgetsDirty();
+}
+
+void UrhoHierarchyList::SetSelection(const ItemVector& items)
+{
+    ClearSelectedItems();
+    for (AbstractHierarchyListItem* item : items)
     {
-        const unsigned index = hierarchyList_->FindItem(itemWidget);
-        if (hierarchyList_->IsSelected(index))
-            hierarchyList_->ToggleSelection(index);
+        if (!multiselect_)
+            ClearSelectedItems();
+        InsertSelectedItem(item);
     }
+    MarkWidgetsDirty();
 }
 
 void UrhoHierarchyList::ExpandItem(AbstractHierarchyListItem* item)
 {
     while (item)
     {
-        UIElement* element = GetInternalElement(item);
-        const unsigned elementIndex = hierarchyList_->FindItem(element);
-        hierarchyList_->Expand(elementIndex, true);
+        item->SetExpanded(true);
         item = item->GetParent();
     }
+    MarkRowsDirty();
 }
 
 void UrhoHierarchyList::GetSelection(ItemVector& result)
 {
-    for (unsigned index : hierarchyList_->GetSelections())
-    {
-        UIElement* element = hierarchyList_->GetItem(index);
-        if (auto item = GetElementItem(element))
-            result.Push(item);
-    }
+    for (AbstractHierarchyListItem* item : selectedItemsOrder_)
+        result.Push(item);
+}
+
+void UrhoHierarchyList::SetHasMoreItems(bool hasMoreItems)
+{
+    hasMoreItems_ = hasMoreItems;
+    MarkWidgetsDirty();
+}
+
+void UrhoHierarchyList::UpdateItem(AbstractHierarchyListItem* /*item*/)
+{
+    // Rows keep uploaded images, so only changed ones are uploaded again
+    MarkWidgetsDirty();
+}
+
+void UrhoHierarchyList::SetOverscan(unsigned overscan)
+{
+    overscan_ = overscan;
+    MarkWidgetsDirty();
 }
 
 void UrhoHierarchyList::OnParentSet()
 {
-    hierarchyList_->SetStyle("HierarchyListView");
-    hierarchyList_->SetInternal(true);
-    hierarchyList_->SetHighlightMode(HM_ALWAYS);
-    hierarchyList_->SetSelectOnClickEnd(true);
-    hierarchyList_->SetHierarchyMode(true);
-    SubscribeToEvent(hierarchyList_, E_ITEMCLICKED,
-        [=](StringHash /*eventType*/, VariantMap& eventData)
+    panel_->SetLayout(LM_HORIZONTAL);
+
+    rowsElement_ = panel_->CreateChild<UIElement>("AHL_Rows");
+    rowsElement_->SetClipChildren(true);
+    SubscribeToEvent(rowsElement_, E_RESIZED,
+        [this](StringHash /*eventType*/, VariantMap& /*eventData*/)
     {
-        UIElement* element = static_cast<UIElement*>(eventData[ItemClicked::P_ITEM].GetPtr());
-        if (auto item = GetElementItem(element))
+        MarkWidgetsDirty();
+    });
+
+    scrollBar_ = panel_->CreateChild<ScrollBar>("AHL_ScrollBar");
+    scrollBar_->SetStyleAuto();
+    scrollBar_->SetOrientation(O_VERTICAL);
+    scrollBar_->SetFixedWidth(12);
+    SubscribeToEvent(scrollBar_, E_SCROLLBARCHANGED,
+        [this](StringHash /*eventType*/, VariantMap& eventData)
+    {
+        const unsigned firstRow = static_cast<unsigned>(Max(0, RoundToInt(eventData[ScrollBarChanged::P_VALUE].GetFloat())));
+        if (firstRow != firstRow_)
         {
-            if (onItemClicked_)
-                onItemClicked_(item);
+            firstRow_ = firstRow;
+            MarkWidgetsDirty();
         }
     });
-    SubscribeToEvent(hierarchyList_, E_ITEMDOUBLECLICKED,
-        [=](StringHash /*eventType*/, VariantMap& eventData)
+
+    SubscribeToEvent(E_UIMOUSECLICK, URHO3D_HANDLER(UrhoHierarchyList, HandleUIMouseClick));
+    SubscribeToEvent(E_UIMOUSEDOUBLECLICK, URHO3D_HANDLER(UrhoHierarchyList, HandleUIMouseDoubleClick));
+    SubscribeToEvent(E_MOUSEWHEEL, URHO3D_HANDLER(UrhoHierarchyList, HandleMouseWheel));
+    SubscribeToEvent(E_POSTUPDATE, URHO3D_HANDLER(UrhoHierarchyList, HandlePostUpdate));
+}
+
+void UrhoHierarchyList::MarkRowsDirty()
+{
+    rowsDirty_ = true;
+    widgetsDirty_ = true;
+}
+
+void UrhoHierarchyList::UpdateRows(AbstractHierarchyListItem* item, unsigned depth)
+{
+    for (unsigned i = 0; i < item->GetNumChildren(); ++i)
+    {
+        AbstractHierarchyListItem* child = item->GetChild(i);
+        rows_.Push(child);
+        rowDepths_.Push(depth);
+        if (child->IsExpanded())
+            UpdateRows(child, depth + 1);
+    }
+}
+
+void UrhoHierarchyList::UpdateRowWidgets()
+{
+    if (!rowsElement_)
+        return;
+
+    // Create enough widgets to fill the area
+    const unsigned numVisibleRows = static_cast<unsigned>((rowsElement_->GetHeight() + rowHeight_ - 1) / rowHeight_);
+    const unsigned numWidgets = numVisibleRows + overscan_;
+    while (rowWidgets_.Size() < numWidgets)
+        rowWidgets_.Push(CreateRowWidgets());
+
+    // Update scroll range
+    const unsigned maxFirstRow = rows_.Size() > numVisibleRows ? rows_.Size() - numVisibleRows : 0;
+    firstRow_ = Min(firstRow_, maxFirstRow);
+    scrollBar_->SetRange(static_cast<float>(maxFirstRow));
+    scrollBar_->SetValue(static_cast<float>(firstRow_));
+
+    // Bind widgets to rows
+    suppressToggle_ = true;
+    const int width = rowsElement_->GetWidth();
+    for (unsigned i = 0; i < rowWidgets_.Size(); ++i)
     {
-        UIElement* element = static_cast<UIElement*>(eventData[ItemClicked::P_ITEM].GetPtr());
-        if (auto item = GetElementItem(element))
+        RowWidgets& widgets = rowWidgets_[i];
+        const unsigned row = firstRow_ + i;
+        if (i >= numWidgets || row >= rows_.Size())
         {
-            if (onItemDoubleClicked_)
-                onItemDoubleClicked_(item);
+            widgets.toggle_->SetVisible(false);
+            widgets.image_->SetVisible(false);
+            widgets.text_->SetVisible(false);
+            continue;
+        }
+
+        AbstractHierarchyListItem* item = rows_[row];
+        const int indent = static_cast<int>(rowDepths_[row]) * rowHeight_;
+        const int y = static_cast<int>(i) * rowHeight_;
+
+        SetElementItem(widgets.toggle_, item);
+        widgets.toggle_->SetVisible(item->GetNumChildren() > 0);
+        widgets.toggle_->SetChecked(item->IsExpanded());
+        widgets.toggle_->SetPosition(indent, y);
+
+        int textIndent = indent + rowHeight_;
+        SetElementItem(widgets.image_, item);
+        widgets.image_->SetPosition(textIndent, y);
+        if (UpdateRowImage(widgets, item))
+            textIndent += rowHeight_;
+
+        SetElementItem(widgets.text_, item);
+        widgets.text_->SetVisible(true);
+        widgets.text_->SetText(item->GetText());
+        widgets.text_->SetSelected(selectedItems_.Contains(item));
+        widgets.text_->SetPosition(textIndent, y);
+        widgets.text_->SetSize(Max(0, width - textIndent), rowHeight_);
+    }
+    suppressToggle_ = false;
+
+    // Added items mark rows dirty, so the request is repeated until the area is filled
+    if (hasMoreItems_ && firstRow_ + numWidgets >= rows_.Size() && onMoreItemsRequested_)
+        onMoreItemsRequested_();
+}
+
+UrhoHierarchyList::RowWidgets UrhoHierarchyList::CreateRowWidgets()
+{
+    RowWidgets widgets;
+
+    widgets.toggle_ = rowsElement_->CreateChild<CheckBox>();
+    widgets.toggle_->SetStyle("HierarchyListViewOverlay");
+    widgets.toggle_->SetFixedSize(rowHeight_, rowHeight_);
+    SubscribeToEvent(widgets.toggle_, E_TOGGLED,
+        [this](StringHash /*eventType*/, VariantMap& eventData)
+    {
+        if (suppressToggle_)
+            return;
+
+        CheckBox* toggle = static_cast<CheckBox*>(eventData[Toggled::P_ELEMENT].GetPtr());
+        if (AbstractHierarchyListItem* item = GetElementItem(toggle))
+        {
+            item->SetExpanded(toggle->IsChecked());
+            MarkRowsDirty();
         }
     });
+
+    widgets.image_ = rowsElement_->CreateChild<BorderImage>();
+    widgets.image_->SetFixedSize(rowHeight_, rowHeight_);
+    widgets.image_->SetBlendMode(BLEND_ALPHA);
+
+    widgets.text_ = rowsElement_->CreateChild<Text>();
+    widgets.text_->SetStyle("FileSelectorListText");
+    widgets.text_->SetEnabled(true);
+
+    return widgets;
 }
 
-void UrhoHierarchyList::InsertItem(AbstractHierarchyListItem* item, unsigned index, AbstractHierarchyListItem* parent)
+bool UrhoHierarchyList::UpdateRowImage(RowWidgets& widgets, AbstractHierarchyListItem* item)
 {
-    auto itemWidget = MakeShared<Text>(context_);
-    SetElementItem(itemWidget, item);
-    itemWidget->SetText(item->GetText());
-    itemWidget->SetStyle("FileSelectorListText");
-    SetInternalElement(item, itemWidget);
+    Image* image = item->GetImage();
+    if (!image || image->GetComponents() != 4)
+    {
+        widgets.image_->SetVisible(false);
+        return false;
+    }
 
-    UIElement* parentWidget = GetInternalElement(parent);
-    hierarchyList_->InsertItem(M_MAX_UNSIGNED, itemWidget, parentWidget);
+    // Rebinding rows happens on every scroll, so upload only images that weren't shown by this row
+    if (widgets.shownImage_.Get() != image)
+    {
+        auto texture = static_cast<Texture2D*>(widgets.image_->GetTexture());
+        if (!texture)
+        {
+            texture = new Texture2D(context_);
+            texture->SetNumLevels(1);
+            widgets.image_->SetTexture(texture);
+        }
+        texture->SetData(image, true);
+        widgets.image_->SetFullImageRect();
+        widgets.shownImage_ = image;
+    }
+    widgets.image_->SetVisible(true);
+    return true;
+}
+
+void UrhoHierarchyList::InsertSelectedItem(AbstractHierarchyListItem* item)
+{
+    if (!selectedItems_.Contains(item))
+    {
+        selectedItems_.Insert(item);
+        selectedItemsOrder_.Push(item);
+    }
+}
+
+bool UrhoHierarchyList::EraseSelectedItem(AbstractHierarchyListItem* item)
+{
+    if (!selectedItems_.Erase(item))
+        return false;
+    selectedItemsOrder_.Remove(item);
+    return true;
+}
+
+void UrhoHierarchyList::ClearSelectedItems()
+{
+    selectedItems_.Clear();
+    selectedItemsOrder_.Clear();
+}
+
+void UrhoHierarchyList::CompactSelectedItems()
+{
+    unsigned count = 0;
+    for (AbstractHierarchyListItem* item : selectedItemsOrder_)
+    {
+        if (selectedItems_.Contains(item))
+            selectedItemsOrder_[count++] = item;
+    }
+    selectedItemsOrder_.Resize(count);
+}
+
+void UrhoHierarchyList::DeselectChildren(AbstractHierarchyListItem* item)
+{
+    selectedItems_.Erase(item);
     for (unsigned i = 0; i < item->GetNumChildren(); ++i)
-        InsertItem(item->GetChild(i), M_MAX_UNSIGNED, item);
-    if (parentWidget)
-        hierarchyList_->Expand(hierarchyList_->FindItem(itemWidget), false);
+        DeselectChildren(item->GetChild(i));
+}
+
+unsigned UrhoHierarchyList::FindRow(AbstractHierarchyListItem* item) const
+{
+    const auto iter = rows_.Find(item);
+    return iter != rows_.End() ? static_cast<unsigned>(iter - rows_.Begin()) : M_MAX_UNSIGNED;
+}
+
+AbstractHierarchyListItem* UrhoHierarchyList::GetRowItem(UIElement* element) const
+{
+    if (!element || !rowsElement_ || element->GetParent() != rowsElement_)
+        return nullptr;
+    return GetElementItem(element);
+}
+
+void UrhoHierarchyList::HandleUIMouseClick(StringHash /*eventType*/, VariantMap& eventData)
+{
+    using namespace UIMouseClick;
+
+    UIElement* element = static_cast<UIElement*>(eventData[P_ELEMENT].GetPtr());
+    AbstractHierarchyListItem* item = GetRowItem(element);
+    if (!item || element->GetType() != Text::GetTypeStatic())
+        return;
+
+    const int qualifiers = eventData[P_QUALIFIERS].GetInt();
+    if (multiselect_ && (qualifiers & QUAL_SHIFT) && lastClickedItem_)
+    {
+        // Select range of rows
+        const unsigned fromRow = FindRow(lastClickedItem_);
+        const unsigned toRow = FindRow(item);
+        if (fromRow != M_MAX_UNSIGNED && toRow != M_MAX_UNSIGNED)
+        {
+            if (!(qualifiers & QUAL_CTRL))
+                ClearSelectedItems();
+            for (unsigned row = Min(fromRow, toRow); row <= Max(fromRow, toRow); ++row)
+                InsertSelectedItem(rows_[row]);
+        }
+    }
+    else if (multiselect_ && (qualifiers & QUAL_CTRL))
+    {
+        // Toggle single row
+        if (!EraseSelectedItem(item))
+            InsertSelectedItem(item);
+        lastClickedItem_ = item;
+    }
+    else
+    {
+        // Select single row
+        ClearSelectedItems();
+        InsertSelectedItem(item);
+        lastClickedItem_ = item;
+    }
+    MarkWidgetsDirty();
+
+    if (onItemClicked_)
+        onItemClicked_(item);
+}
+
+void UrhoHierarchyList::HandleUIMouseDoubleClick(StringHash /*eventType*/, VariantMap& eventData)
+{
+    using namespace UIMouseDoubleClick;
+
+    UIElement* element = static_cast<UIElement*>(eventData[P_ELEMENT].GetPtr());
+    AbstractHierarchyListItem* item = GetRowItem(element);
+    if (!item || element->GetType() != Text::GetTypeStatic())
+        return;
+
+    if (item->GetNumChildren() > 0)
+    {
+        item->SetExpanded(!item->IsExpanded());
+        MarkRowsDirty();
+    }
+
+    if (onItemDoubleClicked_)
+        onItemDoubleClicked_(item);
+}
+
+void UrhoHierarchyList::HandleMouseWheel(StringHash /*eventType*/, VariantMap& eventData)
+{
+    UI* ui = GetSubsystem<UI>();
+    UIElement* hoveredElement = ui->GetElementAt(ui->GetCursorPosition(), false);
+    if (!hoveredElement || (hoveredElement != rowsElement_ && !hoveredElement->IsChildOf(rowsElement_)))
+        return;
+
+    const int wheel = eventData[MouseWheel::P_WHEEL].GetInt();
+    const int firstRow = static_cast<int>(firstRow_) - wheel * 3;
+    firstRow_ = static_cast<unsigned>(Max(0, firstRow));
+    MarkWidgetsDirty();
+}
+
+void UrhoHierarchyList::HandlePostUpdate(StringHash /*eventType*/, VariantMap& /*eventData*/)
+{
+    if (rowsDirty_)
+    {
+        rows_.Clear();
+        rowDepths_.Clear();
+        UpdateRows(&rootItem_, 0);
+        rowsDirty_ = false;
+    }
+
+    // Widgets may be marked dirty again by requested items
+    if (widgetsDirty_)
+    {
+        widgetsDirty_ = false;
+        UpdateRowWidgets();
+    }
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -14,8 +14,8 @@ class LineEdit;
 class Button;
 class CheckBox;
 class ScrollView;
+class ScrollBar;
 class View3D;
-class ListView;
 class DropDownList;
 
 class UrhoMainWindow;
@@ -217,18 +217,93 @@ public:
     void RemoveAllItems() override;
     void SelectItem(AbstractHierarchyListItem* item) override;
     void DeselectItem(AbstractHierarchyListItem* item) override;
+    void SetSelection(const ItemVector& items) override;
     void ExpandItem(AbstractHierarchyListItem* item) override;
     void GetSelection(ItemVector& result) override;
+    void SetHasMoreItems(bool hasMoreItems) override;
+    void UpdateItem(AbstractHierarchyListItem* item) override;
 
+    /// Set number of extra rows created below the visible area.
+    void SetOverscan(unsigned overscan);
 
 private:
+    /// Widgets of single row. Rows are recycled on scroll, so they don't own any item.
+    struct RowWidgets
+    {
+        CheckBox* toggle_ = nullptr;
+        BorderImage* image_ = nullptr;
+        Text* text_ = nullptr;
+        /// Image uploaded to the texture of image widget.
+        WeakPtr<Image> shownImage_;
+    };
+
     void OnParentSet() override;
 
-    void InsertItem(AbstractHierarchyListItem* item, unsigned index, AbstractHierarchyListItem* parent);
+    /// Mark flattened rows as dirty.
+    void MarkRowsDirty();
+    /// Mark row widgets as dirty.
+    void MarkWidgetsDirty() { widgetsDirty_ = true; }
+    /// Flatten expanded children of the item into rows.
+    void UpdateRows(AbstractHierarchyListItem* item, unsigned depth);
+    /// Create row widgets to fill visible area and bind them to rows.
+    void UpdateRowWidgets();
+    /// Create row widgets.
+    RowWidgets CreateRowWidgets();
+    /// Show item image in row widgets. Return whether the item has image.
+    bool UpdateRowImage(RowWidgets& widgets, AbstractHierarchyListItem* item);
+    /// Add item to the end of selection.
+    void InsertSelectedItem(AbstractHierarchyListItem* item);
+    /// Remove item from selection. Return whether the item was selected.
+    bool EraseSelectedItem(AbstractHierarchyListItem* item);
+    /// Clear selection.
+    void ClearSelectedItems();
+    /// Remove item and its children from selection set. Ordered selection shall be compacted then.
+    void DeselectChildren(AbstractHierarchyListItem* item);
+    /// Remove items missing in selection set from ordered selection.
+    void CompactSelectedItems();
+    /// Return row index of the item or M_MAX_UNSIGNED if item is not shown.
+    unsigned FindRow(AbstractHierarchyListItem* item) const;
+    /// Return item of row widget.
+    AbstractHierarchyListItem* GetRowItem(UIElement* element) const;
+
+    void HandleUIMouseClick(StringHash eventType, VariantMap& eventData);
+    void HandleUIMouseDoubleClick(StringHash eventType, VariantMap& eventData);
+    void HandleMouseWheel(StringHash eventType, VariantMap& eventData);
+    void HandlePostUpdate(StringHash eventType, VariantMap& eventData);
 
 private:
-    ListView* hierarchyList_ = nullptr;
+    UIElement* panel_ = nullptr;
+    UIElement* rowsElement_ = nullptr;
+    ScrollBar* scrollBar_ = nullptr;
     AbstractHierarchyListItem rootItem_;
+
+    bool multiselect_ = false;
+    unsigned overscan_ = 2;
+    int rowHeight_ = 16;
+
+    /// Flattened expanded items.
+    PODVector<AbstractHierarchyListItem*> rows_;
+    /// Depths of flattened items.
+    PODVector<unsigned> rowDepths_;
+    /// Whether the rows shall be flattened again.
+    bool rowsDirty_ = true;
+    /// Whether the row widgets shall be re-bound.
+    bool widgetsDirty_ = true;
+    /// First visible row.
+    unsigned firstRow_ = 0;
+    /// Row widgets.
+    Vector<RowWidgets> rowWidgets_;
+    /// Set to ignore toggles caused by row binding.
+    bool suppressToggle_ = false;
+    /// Whether more top-level items may be requested.
+    bool hasMoreItems_ = false;
+
+    /// Selected items.
+    HashSet<AbstractHierarchyListItem*> selectedItems_;
+    /// Selected items in order of selection.
+    PODVector<AbstractHierarchyListItem*> selectedItemsOrder_;
+    /// Last clicked item.
+    WeakPtr<AbstractHierarchyListItem> lastClickedItem_;
 };
 
 class UrhoView3D : public AbstractView3D
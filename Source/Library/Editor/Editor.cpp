@@ -18,11 +18,21 @@ Ray StandardEditorContext::GetMouseRay() const
     return viewportLayout_ ? viewportLayout_->GetCurrentCameraRay() : Ray();
 }
 
+Frustum StandardEditorContext::GetScreenRectFrustum(const IntRect& screenRect) const
+{
+    return viewportLayout_ ? viewportLayout_->ComputeCurrentCameraFrustum(screenRect) : Frustum();
+}
+
 Camera* StandardEditorContext::GetCurrentCamera() const
 {
     return &viewportLayout_->GetCurrentCamera();
 }
 
+IntRect StandardEditorContext::GetCurrentViewportRect() const
+{
+    return viewportLayout_ ? viewportLayout_->GetCurrentViewportRect() : IntRect::ZERO;
+}
+
 //////////////////////////////////////////////////////////////////////////
 Editor::Editor(AbstractMainWindow* mainWindow)
     : Object(mainWindow->GetContext())
@@ -50,8 +50,12 @@ public:
 
     /// \see AbstractEditorContext::GetMouseRay
     Ray GetMouseRay() const override;
+    /// \see AbstractEditorContext::GetScreenRectFrustum
+    Frustum GetScreenRectFrustum(const IntRect& screenRect) const override;
     /// \see AbstractEditorContext::GetCurrentCamera
     Camera* GetCurrentCamera() const override;
+    /// \see AbstractEditorContext::GetCurrentViewportRect
+    IntRect GetCurrentViewportRect() const override;
 
 private:
     /// Viewport layout.
@@ -10,6 +10,11 @@ URHO3D_EVENT(E_EDITORCURRENTVIEWPORTCHANGED, EditorCurrentViewportChanged)
     URHO3D_PARAM(P_CAMERA, Camera);                 // Camera ptr
 }
 
+/// Attributes of inspected objects changed by editor.
+URHO3D_EVENT(E_EDITORATTRIBUTESCHANGED, EditorAttributesChanged)
+{
+}
+
 /// Editor selection changed.
 // URHO3D_EVENT(E_EDITORSELECTIONCHANGED, EditorSelectionChanged)
 // {
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <Urho3D/Math/Frustum.h>
 #include <Urho3D/Math/Ray.h>
+#include <Urho3D/Math/Rect.h>
 #include <Urho3D/Input/Input.h>
 
 namespace Urho3D
@@ -21,8 +23,12 @@ public:
 
     /// Return mouse ray in 3D.
     virtual Ray GetMouseRay() const = 0;
+    /// Return frustum of screen rectangle in 3D.
+    virtual Frustum GetScreenRectFrustum(const IntRect& screenRect) const = 0;
     /// Return current camera.
     virtual Camera* GetCurrentCamera() const = 0;
+    /// Return screen rectangle of current viewport.
+    virtual IntRect GetCurrentViewportRect() const = 0;
 };
 
 /// Interface of editor overlay.
@@ -95,19 +95,69 @@ void EditorViewportLayout::SetLayout(EditorViewportLayoutScheme layout)
     UpdateViewports();
 }
 
+IntRect EditorViewportLayout::GetViewportRect(const Viewport& viewport) const
+{
+    return viewport.GetRect().Size() == IntVector2::ZERO
+        ? IntRect(0, 0, graphics_.GetWidth(), graphics_.GetHeight())
+        : viewport.GetRect();
+}
+
+IntRect EditorViewportLayout::GetCurrentViewportRect() const
+{
+    if (activeViewport_ >= viewports_.Size())
+        return IntRect::ZERO;
+    return GetViewportRect(viewports_[activeViewport_]->GetViewport());
+}
+
 Ray EditorViewportLayout::ComputeCameraRay(const Viewport& viewport, const IntVector2& mousePosition) const
 {
     using namespace Urho3D;
 
-    const IntRect rect = viewport.GetRect().Size() == IntVector2::ZERO
-        ? IntRect(0, 0, graphics_.GetWidth(), graphics_.GetHeight())
-        : viewport.GetRect();
+    const IntRect rect = GetViewportRect(viewport);
 
     return viewport.GetCamera()->GetScreenRay(
         float(mousePosition.x_ - rect.left_) / rect.Width(),
         float(mousePosition.y_ - rect.top_) / rect.Height());
 }
 
+Frustum EditorViewportLayout::ComputeCameraFrustum(const Viewport& viewport, const IntRect& screenRect) const
+{
+    const IntRect rect = GetViewportRect(viewport);
+
+    const float left = float(screenRect.left_ - rect.left_) / rect.Width();
+    const float right = float(screenRect.right_ - rect.left_) / rect.Width();
+    const float top = float(screenRect.top_ - rect.top_) / rect.Height();
+    const float bottom = float(screenRect.bottom_ - rect.top_) / rect.Height();
+
+    // Near and far planes are rectangles, so sub-frustum corners are interpolated from camera frustum corners.
+    // Corners are ordered as top right, bottom right, bottom left, top left; near plane first.
+    const Frustum& cameraFrustum = viewport.GetCamera()->GetFrustum();
+    Frustum frustum;
+    for (unsigned plane = 0; plane < 8; plane += 4)
+    {
+        const Vector3* corners = &cameraFrustum.vertices_[plane];
+        auto interpolate = [=](float x, float y)
+        {
+            const Vector3 topPoint = corners[3].Lerp(corners[0], x);
+            const Vector3 bottomPoint = corners[2].Lerp(corners[1], x);
+            return topPoint.Lerp(bottomPoint, y);
+        };
+        frustum.vertices_[plane + 0] = interpolate(right, top);
+        frustum.vertices_[plane + 1] = interpolate(right, bottom);
+        frustum.vertices_[plane + 2] = interpolate(left, bottom);
+        frustum.vertices_[plane + 3] = interpolate(left, top);
+    }
+    frustum.UpdatePlanes();
+    return frustum;
+}
+
+Frustum EditorViewportLayout::ComputeCurrentCameraFrustum(const IntRect& screenRect) const
+{
+    if (activeViewport_ >= viewports_.Size())
+        return Frustum();
+    return ComputeCameraFrustum(viewports_[activeViewport_]->GetViewport(), screenRect);
+}
+
 Camera& EditorViewportLayout::GetCurrentCamera()
 {
     return viewports_[activeViewport_]->GetCamera();
@@ -84,8 +84,16 @@ public:
     /// Set layout.
     void SetLayout(EditorViewportLayoutScheme layout);
 
+    /// Get screen rectangle of viewport.
+    IntRect GetViewportRect(const Viewport& viewport) const;
+    /// Get screen rectangle of current viewport.
+    IntRect GetCurrentViewportRect() const;
     /// Compute camera ray.
     Ray ComputeCameraRay(const Viewport& viewport, const IntVector2& mousePosition) const;
+    /// Compute camera frustum of screen rectangle.
+    Frustum ComputeCameraFrustum(const Viewport& viewport, const IntRect& screenRect) const;
+    /// Compute current camera frustum of screen rectangle.
+    Frustum ComputeCurrentCameraFrustum(const IntRect& screenRect) const;
     /// Get current camera.
     Camera& GetCurrentCamera();
     /// Get current camera ray.
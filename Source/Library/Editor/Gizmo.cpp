@@ -107,7 +107,7 @@ void Gizmo::Update(AbstractInput& input, AbstractEditorContext& editorContext, f
     if (transforming_ && !stillTransforming)
     {
         transforming_ = false;
-        transformable_->EndTransformation();
+        transformable_->EndTransformation(mergeableTransformation_);
     }
 
     PositionGizmo();
@@ -239,13 +239,15 @@ void Gizmo::MarkMoved()
     OnChanged();
 }
 
-void Gizmo::EnsureTransformationStarted()
+void Gizmo::EnsureTransformationStarted(bool mergeable)
 {
     if (!transforming_)
     {
         transformable_->StartTransformation();
         transforming_ = true;
+        mergeableTransformation_ = true;
     }
+    mergeableTransformation_ = mergeableTransformation_ && mergeable;
 }
 
 bool Gizmo::UseGizmoKeyboard(AbstractInput& input, float timeStep)
@@ -304,17 +306,17 @@ bool Gizmo::UseGizmoKeyboard(AbstractInput& input, float timeStep)
     switch (gizmoType_)
     {
     case GizmoType::Position:
-        EnsureTransformationStarted();
+        EnsureTransformationStarted(true);
         moved = MoveNodes(adjust, false);
         break;
 
     case GizmoType::Rotation:
-        EnsureTransformationStarted();
+        EnsureTransformationStarted(true);
         moved = RotateNodes(adjust, false);
         break;
 
     case GizmoType::Scale:
-        EnsureTransformationStarted();
+        EnsureTransformationStarted(true);
         moved = ScaleNodes(adjust, false);
         break;
     }
@@ -376,7 +378,7 @@ bool Gizmo::UseGizmoMouse(AbstractInput& input, const Ray& mouseRay)
     const bool snapped = controls_[SNAP_DRAG].IsDown(input);
     if (gizmoType_ == GizmoType::Position)
     {
-        EnsureTransformationStarted();
+        EnsureTransformationStarted(false);
 
         Vector3 adjust(0, 0, 0);
         if (axisX_.selected)
@@ -390,7 +392,7 @@ bool Gizmo::UseGizmoMouse(AbstractInput& input, const Ray& mouseRay)
     }
     else if (gizmoType_ == GizmoType::Rotation)
     {
-        EnsureTransformationStarted();
+        EnsureTransformationStarted(false);
 
         Vector3 adjust(0, 0, 0);
         if (axisX_.selected)
@@ -404,7 +406,7 @@ bool Gizmo::UseGizmoMouse(AbstractInput& input, const Ray& mouseRay)
     }
     else if (gizmoType_ == GizmoType::Scale)
     {
-        EnsureTransformationStarted();
+        EnsureTransformationStarted(false);
 
         Vector3 adjust(0, 0, 0);
         if (axisX_.selected)
@@ -115,8 +115,8 @@ private:
     void CalculateGizmoAxes();
     /// Mark gizmo moved.
     void MarkMoved();
-    /// Start transformation.
-    void EnsureTransformationStarted();
+    /// Start transformation. Transformation stays mergeable only while all its changes are mergeable.
+    void EnsureTransformationStarted(bool mergeable);
     /// Use gizmo (by keyboard).
     bool UseGizmoKeyboard(AbstractInput& input, float timeStep);
     /// Use gizmo (by mouse). Return true if selected.
@@ -159,6 +159,8 @@ private:
 
     /// Whether the gizmo is transforming now.
     bool transforming_ = false;
+    /// Whether current transformation may be merged into previous one.
+    bool mergeableTransformation_ = false;
     /// Whether ths gizmo is dragged by mouse.
     bool dragging_ = false;
 
@@ -1,5 +1,7 @@
 #include "HierarchyWindow.h"
 #include "EditorEvents.h"
+#include <Urho3D/Container/Sort.h>
+#include <Urho3D/Core/CoreEvents.h>
 #include <Urho3D/Scene/SceneEvents.h>
 #include <Urho3D/Scene/Scene.h>
 #include <Urho3D/Scene/Component.h>
@@ -32,6 +34,7 @@ Hierarchy::Hierarchy(AbstractWidgetStack* stack, Object* document)
         itemContextMenu_->Show();
     };
     SetScene(scene_);
+    SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(Hierarchy, HandleEndFrame));
 
     itemContextMenu_ = stack->GetMainWindow()->CreateContextMenu(AbstractMenuItem({
         AbstractMenuItem("First"),
@@ -50,6 +53,11 @@ void Hierarchy::RefreshSelection()
     HandleEditorSelectionChanged();
 }
 
+void Hierarchy::RefreshSelection(const Selection::ObjectVector& addedObjects, const Selection::ObjectVector& removedObjects)
+{
+    HandleEditorSelectionDelta(addedObjects, removedObjects);
+}
+
 void Hierarchy::SetScene(Scene* scene)
 {
     if (scene_)
@@ -63,6 +71,8 @@ void Hierarchy::SetScene(Scene* scene)
         UnsubscribeFromEvent(scene_, E_COMPONENTENABLEDCHANGED);
         RemoveListItem(scene_);
     }
+    pendingObjects_.Clear();
+    pendingObjectsSet_.Clear();
     scene_ = scene;
     if (scene_)
     {
@@ -85,11 +95,17 @@ void Hierarchy::SetSelection(Selection* selection)
 AbstractHierarchyListItem* Hierarchy::FindItem(Object* object)
 {
     if (object)
-        return objectsToItems_[WeakPtr<Object>(object)];
+        return FindItem(WeakPtr<Object>(object));
     else
         return nullptr;
 }
 
+AbstractHierarchyListItem* Hierarchy::FindItem(const WeakPtr<Object>& object)
+{
+    auto iter = objectsToItems_.Find(object);
+    return iter != objectsToItems_.End() ? iter->second_.Get() : nullptr;
+}
+
 void Hierarchy::Subtract(const Selection::ObjectVector& lhs, const Selection::ObjectSet& rhs, Selection::ObjectSet& result) const
 {
     result.Clear();
@@ -130,23 +146,35 @@ AbstractHierarchyListItem* Hierarchy::CreateListItem(Object* object)
     return item;
 }
 
-void Hierarchy::GetObjectParentAndIndex(Object* object, Object*& parent, unsigned& index)
+Object* Hierarchy::GetObjectParent(Object* object)
 {
-    parent = nullptr;
-    index = 0;
+    if (auto node = dynamic_cast<Node*>(object))
+        return node->GetParent();
+    else if (auto component = dynamic_cast<Component*>(object))
+        return component->GetNode();
+    return nullptr;
+}
 
+unsigned Hierarchy::GetObjectIndex(Object* object)
+{
+    // Same order as in CreateListItem
     if (auto node = dynamic_cast<Node*>(object))
     {
         Node* parentNode = node->GetParent();
-        parent = parentNode;
-        index = parentNode ? parentNode->GetChildren().IndexOf(SharedPtr<Node>(node)) : M_MAX_UNSIGNED;
+        return parentNode ? parentNode->GetNumComponents() + parentNode->GetChildren().IndexOf(SharedPtr<Node>(node)) : M_MAX_UNSIGNED;
     }
     else if (auto component = dynamic_cast<Component*>(object))
     {
         Node* parentNode = component->GetNode();
-        parent = parentNode;
-        index = parentNode->GetNumChildren() + parentNode->GetComponents().IndexOf(SharedPtr<Component>(component));
+        return parentNode->GetComponents().IndexOf(SharedPtr<Component>(component));
     }
+    return 0;
+}
+
+void Hierarchy::GetObjectParentAndIndex(Object* object, Object*& parent, unsigned& index)
+{
+    parent = GetObjectParent(object);
+    index = GetObjectIndex(object);
 }
 
 void Hierarchy::UpdateListItem(Object* object)
@@ -164,8 +192,115 @@ void Hierarchy::UpdateListItem(Object* object)
 
 void Hierarchy::RemoveListItem(Object* object)
 {
-    AbstractHierarchyListItem* objectItem = FindItem(object);
-    hierarchyList_->RemoveItem(objectItem);
+    if (AbstractHierarchyListItem* objectItem = FindItem(object))
+    {
+        UnmapListItem(objectItem);
+        hierarchyList_->RemoveItem(objectItem);
+    }
+}
+
+void Hierarchy::UnmapListItem(AbstractHierarchyListItem* item)
+{
+    objectsToItems_.Erase(static_cast<HierarchyWindowItem*>(item)->GetWeakObject());
+    for (unsigned i = 0; i < item->GetNumChildren(); ++i)
+        UnmapListItem(item->GetChild(i));
+}
+
+bool Hierarchy::IsInScene(Object* object) const
+{
+    if (auto node = dynamic_cast<Node*>(object))
+        return node->GetScene() == scene_;
+    else if (auto component = dynamic_cast<Component*>(object))
+        return component->GetNode() && component->GetNode()->GetScene() == scene_;
+    return false;
+}
+
+void Hierarchy::QueueObjectChange(Object* object)
+{
+    WeakPtr<Object> weakObject(object);
+    if (object && !pendingObjectsSet_.Contains(weakObject))
+    {
+        pendingObjects_.Push(weakObject);
+        pendingObjectsSet_.Insert(weakObject);
+    }
+}
+
+void Hierarchy::ApplyPendingChanges()
+{
+    if (pendingObjects_.Empty())
+        return;
+
+    Selection::ObjectVector pendingObjects;
+    pendingObjects.Swap(pendingObjects_);
+    pendingObjectsSet_.Clear();
+
+    // Detach all changed items first, so remaining items keep the order of the scene
+    Vector<PendingInsertion> insertions;
+    for (const WeakPtr<Object>& object : pendingObjects)
+        DetachObjectItem(object, insertions);
+
+    // Parents go before children and siblings go in ascending order, so final indices are valid on insertion
+    Sort(insertions.Begin(), insertions.End(), [](const PendingInsertion& lhs, const PendingInsertion& rhs)
+    {
+        return lhs.depth_ != rhs.depth_ ? lhs.depth_ < rhs.depth_ : lhs.index_ < rhs.index_;
+    });
+    for (const PendingInsertion& insertion : insertions)
+        InsertObjectItem(insertion);
+}
+
+void Hierarchy::DetachObjectItem(const WeakPtr<Object>& object, Vector<PendingInsertion>& insertions)
+{
+    // Scene item is managed by SetScene
+    if (object.Get() == scene_.Get())
+        return;
+
+    // Keep the item alive while it is moved
+    SharedPtr<AbstractHierarchyListItem> objectItem(FindItem(object));
+
+    // Find where the object is now
+    AbstractHierarchyListItem* parentItem = nullptr;
+    if (object && IsInScene(object))
+        parentItem = FindItem(GetObjectParent(object));
+
+    // Remove item if object is gone. If parent item is missing too, it will be created later with all children
+    if (objectItem)
+    {
+        if (!parentItem)
+            UnmapListItem(objectItem);
+        hierarchyList_->RemoveItem(objectItem);
+    }
+    if (!parentItem)
+        return;
+
+    PendingInsertion insertion;
+    insertion.object_ = object;
+    insertion.item_ = objectItem;
+    for (Object* parent = GetObjectParent(object); parent; parent = GetObjectParent(parent))
+        ++insertion.depth_;
+    // Sibling index lookup is linear, so do it only when item is actually inserted
+    insertion.index_ = GetObjectIndex(object);
+    insertions.Push(insertion);
+}
+
+void Hierarchy::InsertObjectItem(const PendingInsertion& insertion)
+{
+    // Skip if item was created with its parent
+    Object* object = insertion.object_;
+    if (FindItem(object) != insertion.item_.Get())
+        return;
+
+    // Drop the item if its parent was removed after it had been detached
+    AbstractHierarchyListItem* parentItem = FindItem(GetObjectParent(object));
+    if (!parentItem)
+    {
+        if (insertion.item_)
+            UnmapListItem(insertion.item_);
+        return;
+    }
+
+    // Move existing item with its children or create new one
+    AbstractHierarchyListItem* objectItem = insertion.item_ ? insertion.item_.Get() : CreateListItem(object);
+    hierarchyList_->AddItem(objectItem, insertion.index_, parentItem);
 }
 
 void Hierarchy::HandleListSelectionChanged()
@@ -181,54 +316,109 @@ void Hierarchy::HandleEditorSelectionChanged()
     if (suppressEditorSelectionChanges_)
         return;
 
+    // Selected objects may be not in the list yet
+    ApplyPendingChanges();
     CacheSelection();
 
     Selection::ObjectSet toSelect;
     Subtract(selection_->GetObjects(), cachedSelectionSet_, toSelect);
 
-    Selection::ObjectSet toDeselect;
-    Subtract(cachedSelection_, selection_->GetObjectsSet(), toDeselect);
+    // Skip if nothing is changed
+    if (toSelect.Empty() && cachedSelection_.Size() == selection_->GetObjects().Size())
+        return;
 
-    // Deselect old objects
-    for (Object* object : toDeselect)
+    // Expand new objects
+    for (Object* object : toSelect)
+    {
         if (AbstractHierarchyListItem* item = FindItem(object))
-            hierarchyList_->DeselectItem(item);
+            hierarchyList_->ExpandItem(item);
+    }
 
-    // Select new objects
-    for (Object* object : toSelect)
+    // Select all objects at once
+    AbstractHierarchyList::ItemVector items;
+    for (Object* object : selection_->GetObjects())
+    {
+        if (AbstractHierarchyListItem* item = FindItem(object))
+            items.Push(item);
+    }
+    hierarchyList_->SetSelection(items);
+
+    CacheSelection();
+}
+
+void Hierarchy::HandleEditorSelectionDelta(const Selection::ObjectVector& addedObjects, const Selection::ObjectVector& removedObjects)
+{
+    if (suppressEditorSelectionChanges_)
+        return;
+
+    // Replacing whole selection is cheaper for big changes
+    const unsigned numChanges = addedObjects.Size() + removedObjects.Size();
+    if (numChanges > selection_->GetNumObjects())
+    {
+        HandleEditorSelectionChanged();
+        return;
+    }
+
+    // Selected objects may be not in the list yet
+    ApplyPendingChanges();
+
+    // Apply delta to cached selection and update the list at once
+    Selection::ObjectSet removedSet;
+    for (const WeakPtr<Object>& object : removedObjects)
+        removedSet.Insert(object);
+
+    AbstractHierarchyList::ItemVector items;
+    for (const WeakPtr<Object>& object : cachedSelection_)
     {
+        if (removedSet.Contains(object))
+            continue;
+        if (AbstractHierarchyListItem* item = FindItem(object))
+            items.Push(item);
+    }
+
+    // Added items go last, so the list scrolls to them
+    for (const WeakPtr<Object>& object : addedObjects)
+    {
+        if (cachedSelectionSet_.Contains(object))
+            continue;
         if (AbstractHierarchyListItem* item = FindItem(object))
         {
             hierarchyList_->ExpandItem(item);
-            hierarchyList_->SelectItem(item);
+            items.Push(item);
         }
     }
+    hierarchyList_->SetSelection(items);
 
     CacheSelection();
 }
 
+void Hierarchy::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    ApplyPendingChanges();
+}
+
 void Hierarchy::HandleNodeAdded(StringHash eventType, VariantMap& eventData)
 {
     Node* node = dynamic_cast<Node*>(eventData[NodeAdded::P_NODE].GetPtr());
-    UpdateListItem(node);
+    QueueObjectChange(node);
 }
 
 void Hierarchy::HandleNodeRemoved(StringHash eventType, VariantMap& eventData)
 {
     Node* node = dynamic_cast<Node*>(eventData[NodeRemoved::P_NODE].GetPtr());
-    RemoveListItem(node);
+    QueueObjectChange(node);
 }
 
 void Hierarchy::HandleComponentAdded(StringHash eventType, VariantMap& eventData)
 {
     Component* component = dynamic_cast<Component*>(eventData[ComponentAdded::P_COMPONENT].GetPtr());
-    UpdateListItem(component);
+    QueueObjectChange(component);
 }
 
 void Hierarchy::HandleComponentRemoved(StringHash eventType, VariantMap& eventData)
 {
     Component* component = dynamic_cast<Component*>(eventData[ComponentRemoved::P_COMPONENT].GetPtr());
-    RemoveListItem(component);
+    QueueObjectChange(component);
 }
 
 void Hierarchy::HandleNodeNameChanged(StringHash eventType, VariantMap& eventData)
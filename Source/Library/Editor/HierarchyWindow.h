@@ -17,11 +17,12 @@ class HierarchyWindowItem : public AbstractHierarchyListItem
 public:
     HierarchyWindowItem(Object* object) : AbstractHierarchyListItem(object->GetContext()), object_(object) { }
     Object* GetObject() { return object_; }
+    const WeakPtr<Object>& GetWeakObject() const { return object_; }
 
     String GetText() override;
 
 private:
-    Object* object_ = nullptr;
+    WeakPtr<Object> object_;
 };
 
 class Hierarchy : public Object
@@ -32,32 +33,67 @@ public:
     Hierarchy(AbstractWidgetStack* stack, Object* document);
     ~Hierarchy() override;
     void RefreshSelection();
+    /// Update list selection with changes of editor selection.
+    void RefreshSelection(const Selection::ObjectVector& addedObjects, const Selection::ObjectVector& removedObjects);
     void SetScene(Scene* scene);
     void SetSelection(Selection* selection);
     const Selection::ObjectVector& GetSelectedObjects() { return cachedSelection_; }
 
 private:
     AbstractHierarchyListItem* FindItem(Object* object);
+    AbstractHierarchyListItem* FindItem(const WeakPtr<Object>& object);
     /// Subtract right set from left one.
     void Subtract(const Selection::ObjectVector& lhs, const Selection::ObjectSet& rhs, Selection::ObjectSet& result) const;
     /// Gather selection from hierarchy list.
     void CacheSelection();
     AbstractHierarchyListItem* CreateListItem(Object* object);
+    /// Return parent node of the object.
+    Object* GetObjectParent(Object* object);
+    /// Return index of the object item among siblings, components go first. Linear in number of siblings.
+    unsigned GetObjectIndex(Object* object);
     void GetObjectParentAndIndex(Object* object, Object*& parent, unsigned& index);
     void UpdateListItem(Object* object);
     void RemoveListItem(Object* object);
+    /// Remove item and its children from objects-to-items map.
+    void UnmapListItem(AbstractHierarchyListItem* item);
+
+    /// Return whether the object is attached to the scene.
+    bool IsInScene(Object* object) const;
+    /// Queue object for update at the end of the frame.
+    void QueueObjectChange(Object* object);
+    /// Apply all queued changes to the list.
+    void ApplyPendingChanges();
+    /// Item waiting for insertion into the list.
+    struct PendingInsertion
+    {
+        /// Object of the item.
+        WeakPtr<Object> object_;
+        /// Existing item or null if the item shall be created.
+        SharedPtr<AbstractHierarchyListItem> item_;
+        /// Depth of the object in the scene.
+        unsigned depth_ = 0;
+        /// Final index of the item among siblings.
+        unsigned index_ = 0;
+    };
+    /// Remove object item if object is gone, otherwise detach it and queue for insertion.
+    void DetachObjectItem(const WeakPtr<Object>& object, Vector<PendingInsertion>& insertions);
+    /// Insert queued object item unless it was already created with its parent.
+    void InsertObjectItem(const PendingInsertion& insertion);
 
     // @name Editor and UI Events
     // @{
 
     void HandleListSelectionChanged();
     void HandleEditorSelectionChanged();
+    void HandleEditorSelectionDelta(const Selection::ObjectVector& addedObjects, const Selection::ObjectVector& removedObjects);
 
     // @}
 
     // @name Scene Events
     // @{
 
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+
     void HandleNodeAdded(StringHash eventType, VariantMap& eventData);
     void HandleNodeRemoved(StringHash eventType, VariantMap& eventData);
     void HandleComponentAdded(StringHash eventType, VariantMap& eventData);
@@ -86,6 +122,10 @@ private:
     SharedPtr<Scene> scene_;
     SharedPtr<Selection> selection_;
     HashMap<WeakPtr<Object>, WeakPtr<AbstractHierarchyListItem>> objectsToItems_;
+    /// Objects changed since last update, in order of arrival.
+    Selection::ObjectVector pendingObjects_;
+    /// Set of objects changed since last update.
+    Selection::ObjectSet pendingObjectsSet_;
 
     bool suppressEditorSelectionChanges_ = false;
     Selection::ObjectVector cachedSelection_;
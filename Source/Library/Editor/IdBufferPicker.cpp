@@ -0,0 +1,283 @@
+#include "IdBufferPicker.h"
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/VertexBuffer.h>
+
+namespace Urho3D
+{
+
+void IdBufferPicker::Update(Octree* octree, Camera* camera, const IntRect& viewportRect, unsigned drawableFlags, unsigned sceneRevision)
+{
+    if (!octree || !camera || viewportRect.Width() <= 0 || viewportRect.Height() <= 0)
+    {
+        valid_ = false;
+        drawables_.Clear();
+        return;
+    }
+
+    const Matrix3x4 view = camera->GetView();
+    const Matrix4 projection = camera->GetProjection();
+    if (valid_ && view_ == view && projection_ == projection && viewportRect_ == viewportRect
+        && drawableFlags_ == drawableFlags && sceneRevision_ == sceneRevision)
+        return;
+
+    view_ = view;
+    projection_ = projection;
+    viewportRect_ = viewportRect;
+    drawableFlags_ = drawableFlags;
+    sceneRevision_ = sceneRevision;
+    nearClip_ = camera->GetNearClip();
+    Rebuild(octree, camera, drawableFlags);
+    valid_ = true;
+}
+
+Drawable* IdBufferPicker::GetDrawable(const IntVector2& screenPosition) const
+{
+    if (!valid_)
+        return nullptr;
+
+    const IntVector2 position = ToBufferPosition(screenPosition);
+    if (position.x_ < 0 || position.y_ < 0 || position.x_ >= width_ || position.y_ >= height_)
+        return nullptr;
+
+    const unsigned id = ids_[position.y_ * width_ + position.x_];
+    return id ? drawables_[id - 1].Get() : nullptr;
+}
+
+void IdBufferPicker::GetDrawables(const IntRect& screenRect, PODVector<Drawable*>& result) const
+{
+    result.Clear();
+    if (!valid_)
+        return;
+
+    const IntVector2 minPosition = ToBufferPosition(IntVector2(screenRect.left_, screenRect.top_));
+    const IntVector2 maxPosition = ToBufferPosition(IntVector2(screenRect.right_, screenRect.bottom_));
+    const int minX = Max(0, minPosition.x_);
+    const int minY = Max(0, minPosition.y_);
+    const int maxX = Min(width_ - 1, maxPosition.x_);
+    const int maxY = Min(height_ - 1, maxPosition.y_);
+
+    PODVector<bool> found(drawables_.Size());
+    for (bool& flag : found)
+        flag = false;
+
+    for (int y = minY; y <= maxY; ++y)
+    {
+        for (int x = minX; x <= maxX; ++x)
+        {
+            const unsigned id = ids_[y * width_ + x];
+            if (!id || found[id - 1])
+                continue;
+
+            found[id - 1] = true;
+            if (Drawable* drawable = drawables_[id - 1])
+                result.Push(drawable);
+        }
+    }
+}
+
+void IdBufferPicker::Rebuild(Octree* octree, Camera* camera, unsigned drawableFlags)
+{
+    width_ = Max(1, viewportRect_.Width() / downscale_);
+    height_ = Max(1, viewportRect_.Height() / downscale_);
+    ids_.Resize(width_ * height_);
+    depths_.Resize(width_ * height_);
+    for (unsigned& id : ids_)
+        id = 0;
+    for (float& depth : depths_)
+        depth = M_INFINITY;
+
+    PODVector<Drawable*> result;
+    FrustumOctreeQuery query(result, camera->GetFrustum(), drawableFlags, camera->GetViewMask());
+    octree->GetDrawables(query);
+
+    drawables_.Clear();
+    for (Drawable* drawable : result)
+    {
+        drawables_.Push(WeakPtr<Drawable>(drawable));
+        const unsigned id = drawables_.Size();
+        if (boundingBoxesOnly_ || !RasterizeGeometry(drawable, id))
+            RasterizeBox(drawable->GetWorldBoundingBox(), id);
+    }
+}
+
+bool IdBufferPicker::RasterizeGeometry(Drawable* drawable, unsigned id)
+{
+    const Vector<SourceBatch>& batches = drawable->GetBatches();
+    if (batches.Empty())
+        return false;
+
+    // Skinned and instanced geometries are not supported
+    for (const SourceBatch& batch : batches)
+    {
+        Geometry* geometry = batch.geometry_;
+        if (!geometry || batch.geometryType_ != GEOM_STATIC || batch.numWorldTransforms_ != 1
+            || geometry->GetPrimitiveType() != TRIANGLE_LIST)
+            return false;
+
+        const unsigned char* vertexData;
+        const unsigned char* indexData;
+        unsigned vertexSize;
+        unsigned indexSize;
+        const PODVector<VertexElement>* elements;
+        geometry->GetRawData(vertexData, vertexSize, indexData, indexSize, elements);
+        if (!vertexData || !elements || VertexBuffer::GetElementOffset(*elements, TYPE_VECTOR3, SEM_POSITION) != 0)
+            return false;
+    }
+
+    for (const SourceBatch& batch : batches)
+    {
+        Geometry* geometry = batch.geometry_;
+        const unsigned char* vertexData;
+        const unsigned char* indexData;
+        unsigned vertexSize;
+        unsigned indexSize;
+        const PODVector<VertexElement>* elements;
+        geometry->GetRawData(vertexData, vertexSize, indexData, indexSize, elements);
+
+        const Matrix3x4 modelView = view_ * *batch.worldTransform_;
+        auto getVertex = [=](unsigned index)
+        {
+            return modelView * *reinterpret_cast<const Vector3*>(vertexData + index * vertexSize);
+        };
+
+        if (indexData)
+        {
+            const unsigned indexStart = geometry->GetIndexStart();
+            const unsigned indexEnd = indexStart + geometry->GetIndexCount();
+            const unsigned short* shortIndices = reinterpret_cast<const unsigned short*>(indexData);
+            const unsigned* largeIndices = reinterpret_cast<const unsigned*>(indexData);
+            for (unsigned i = indexStart; i + 2 < indexEnd; i += 3)
+            {
+                if (indexSize == sizeof(unsigned short))
+                    RasterizeTriangle(getVertex(shortIndices[i]), getVertex(shortIndices[i + 1]), getVertex(shortIndices[i + 2]), id);
+                else
+                    RasterizeTriangle(getVertex(largeIndices[i]), getVertex(largeIndices[i + 1]), getVertex(largeIndices[i + 2]), id);
+            }
+        }
+        else
+        {
+            const unsigned vertexStart = geometry->GetVertexStart();
+            const unsigned vertexEnd = vertexStart + geometry->GetVertexCount();
+            for (unsigned i = vertexStart; i + 2 < vertexEnd; i += 3)
+                RasterizeTriangle(getVertex(i), getVertex(i + 1), getVertex(i + 2), id);
+        }
+    }
+    return true;
+}
+
+void IdBufferPicker::RasterizeBox(const BoundingBox& box, unsigned id)
+{
+    // Corner index bits select max coordinate for X, Y and Z
+    Vector3 corners[8];
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        const Vector3 corner(
+            i & 1 ? box.max_.x_ : box.min_.x_,
+            i & 2 ? box.max_.y_ : box.min_.y_,
+            i & 4 ? box.max_.z_ : box.min_.z_);
+        corners[i] = view_ * corner;
+    }
+
+    static const unsigned faces[6][4] =
+    {
+        { 0, 2, 6, 4 }, { 1, 3, 7, 5 },
+        { 0, 1, 5, 4 }, { 2, 3, 7, 6 },
+        { 0, 1, 3, 2 }, { 4, 5, 7, 6 }
+    };
+    for (const auto& face : faces)
+    {
+        RasterizeTriangle(corners[face[0]], corners[face[1]], corners[face[2]], id);
+        RasterizeTriangle(corners[face[0]], corners[face[2]], corners[face[3]], id);
+    }
+}
+
+void IdBufferPicker::RasterizeTriangle(const Vector3& v0, const Vector3& v1, const Vector3& v2, unsigned id)
+{
+    // Clip by near plane, up to one extra vertex may appear
+    const Vector3 vertices[3] = { v0, v1, v2 };
+    Vector3 clipped[4];
+    unsigned numClipped = 0;
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        const Vector3& current = vertices[i];
+        const Vector3& next = vertices[(i + 1) % 3];
+        const bool currentInside = current.z_ >= nearClip_;
+        const bool nextInside = next.z_ >= nearClip_;
+        if (currentInside)
+            clipped[numClipped++] = current;
+        if (currentInside != nextInside)
+            clipped[numClipped++] = current.Lerp(next, (nearClip_ - current.z_) / (next.z_ - current.z_));
+    }
+
+    if (numClipped < 3)
+        return;
+
+    Vector4 projected[4];
+    for (unsigned i = 0; i < numClipped; ++i)
+        projected[i] = projection_ * Vector4(clipped[i], 1.0f);
+    for (unsigned i = 1; i + 1 < numClipped; ++i)
+        RasterizeClippedTriangle(projected[0], projected[i], projected[i + 1], id);
+}
+
+void IdBufferPicker::RasterizeClippedTriangle(const Vector4& v0, const Vector4& v1, const Vector4& v2, unsigned id)
+{
+    // Convert to buffer coordinates, keep normalized depth
+    const Vector4* vertices[3] = { &v0, &v1, &v2 };
+    Vector3 points[3];
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        const Vector4& vertex = *vertices[i];
+        const float invW = 1.0f / vertex.w_;
+        points[i] = Vector3(
+            (vertex.x_ * invW * 0.5f + 0.5f) * width_,
+            (0.5f - vertex.y_ * invW * 0.5f) * height_,
+            vertex.z_ * invW);
+    }
+
+    const Vector3& p0 = points[0];
+    const Vector3& p1 = points[1];
+    const Vector3& p2 = points[2];
+    const float area = (p1.x_ - p0.x_) * (p2.y_ - p0.y_) - (p1.y_ - p0.y_) * (p2.x_ - p0.x_);
+    if (Abs(area) < M_EPSILON)
+        return;
+
+    // Both windings are accepted
+    const float invArea = 1.0f / area;
+    const int minX = FloorToInt(Clamp(Min(Min(p0.x_, p1.x_), p2.x_), 0.0f, (float)width_));
+    const int minY = FloorToInt(Clamp(Min(Min(p0.y_, p1.y_), p2.y_), 0.0f, (float)height_));
+    const int maxX = Min(width_ - 1, CeilToInt(Clamp(Max(Max(p0.x_, p1.x_), p2.x_), 0.0f, (float)width_)));
+    const int maxY = Min(height_ - 1, CeilToInt(Clamp(Max(Max(p0.y_, p1.y_), p2.y_), 0.0f, (float)height_)));
+
+    for (int y = minY; y <= maxY; ++y)
+    {
+        for (int x = minX; x <= maxX; ++x)
+        {
+            const float px = x + 0.5f;
+            const float py = y + 0.5f;
+            const float b0 = ((p2.x_ - p1.x_) * (py - p1.y_) - (p2.y_ - p1.y_) * (px - p1.x_)) * invArea;
+            const float b1 = ((p0.x_ - p2.x_) * (py - p2.y_) - (p0.y_ - p2.y_) * (px - p2.x_)) * invArea;
+            const float b2 = 1.0f - b0 - b1;
+            if (b0 < 0.0f || b1 < 0.0f || b2 < 0.0f)
+                continue;
+
+            const float depth = b0 * p0.z_ + b1 * p1.z_ + b2 * p2.z_;
+            const unsigned index = y * width_ + x;
+            if (depth < depths_[index])
+            {
+                depths_[index] = depth;
+                ids_[index] = id;
+            }
+        }
+    }
+}
+
+IntVector2 IdBufferPicker::ToBufferPosition(const IntVector2& screenPosition) const
+{
+    return IntVector2(
+        (screenPosition.x_ - viewportRect_.left_) * width_ / viewportRect_.Width(),
+        (screenPosition.y_ - viewportRect_.top_) * height_ / viewportRect_.Height());
+}
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Math/BoundingBox.h>
+#include <Urho3D/Math/Matrix3x4.h>
+#include <Urho3D/Math/Rect.h>
+
+namespace Urho3D
+{
+
+class Camera;
+class Drawable;
+class Octree;
+
+/// Picks drawables by looking up buffer of drawable IDs rasterized in software.
+class IdBufferPicker : public Object
+{
+    URHO3D_OBJECT(IdBufferPicker, Object);
+
+public:
+    /// Construct.
+    IdBufferPicker(Context* context) : Object(context) { }
+    /// Set ratio of viewport size to buffer size.
+    void SetDownscale(int downscale) { downscale_ = Max(1, downscale); Invalidate(); }
+    /// Set whether to rasterize bounding boxes instead of triangles.
+    void SetBoundingBoxesOnly(bool boundingBoxesOnly) { boundingBoxesOnly_ = boundingBoxesOnly; Invalidate(); }
+    /// Force rebuild of buffer on next update.
+    void Invalidate() { valid_ = false; }
+    /// Rebuild buffer if any of parameters is changed.
+    void Update(Octree* octree, Camera* camera, const IntRect& viewportRect, unsigned drawableFlags, unsigned sceneRevision);
+
+    /// Return drawable at screen position.
+    Drawable* GetDrawable(const IntVector2& screenPosition) const;
+    /// Return all drawables visible in screen rectangle.
+    void GetDrawables(const IntRect& screenRect, PODVector<Drawable*>& result) const;
+
+private:
+    /// Rebuild buffer.
+    void Rebuild(Octree* octree, Camera* camera, unsigned drawableFlags);
+    /// Rasterize drawable geometry. Return false if geometry is not accessible.
+    bool RasterizeGeometry(Drawable* drawable, unsigned id);
+    /// Rasterize bounding box.
+    void RasterizeBox(const BoundingBox& box, unsigned id);
+    /// Rasterize triangle in view space.
+    void RasterizeTriangle(const Vector3& v0, const Vector3& v1, const Vector3& v2, unsigned id);
+    /// Rasterize triangle in clip space that is in front of the camera.
+    void RasterizeClippedTriangle(const Vector4& v0, const Vector4& v1, const Vector4& v2, unsigned id);
+    /// Convert screen position to buffer position.
+    IntVector2 ToBufferPosition(const IntVector2& screenPosition) const;
+
+private:
+    /// Ratio of viewport size to buffer size.
+    int downscale_ = 2;
+    /// Whether to rasterize bounding boxes instead of triangles.
+    bool boundingBoxesOnly_ = false;
+
+    /// Whether the buffer is valid.
+    bool valid_ = false;
+    /// Camera view of buffer.
+    Matrix3x4 view_;
+    /// Camera projection of buffer.
+    Matrix4 projection_;
+    /// Viewport rectangle of buffer.
+    IntRect viewportRect_;
+    /// Drawable flags of buffer.
+    unsigned drawableFlags_ = 0;
+    /// Scene revision of buffer.
+    unsigned sceneRevision_ = 0;
+    /// Near clip distance of buffer.
+    float nearClip_ = 0.0f;
+
+    /// Buffer width.
+    int width_ = 0;
+    /// Buffer height.
+    int height_ = 0;
+    /// Drawable IDs, zero if empty. ID is index in drawables vector plus one.
+    PODVector<unsigned> ids_;
+    /// Depths.
+    PODVector<float> depths_;
+    /// Rasterized drawables.
+    Vector<WeakPtr<Drawable>> drawables_;
+};
+
+}
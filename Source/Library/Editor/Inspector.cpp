@@ -1,4 +1,5 @@
 #include "Inspector.h"
+#include "EditorEvents.h"
 #include <Urho3D/Core/StringUtils.h>
 
 namespace Urho3D
@@ -171,7 +172,7 @@ void MultipleSerializableInspector::BuildUI(AbstractLayout* layout)
         return;
 
     const Vector<AttributeInfo>& attributes = *objects_[0]->GetAttributes();
-    Vector<Variant> values;
+    editorValues_.Resize(attributes.Size());
     unsigned row = 0;
     for (unsigned i = 0; i < attributes.Size(); ++i)
     {
@@ -201,8 +202,7 @@ void MultipleSerializableInspector::BuildUI(AbstractLayout* layout)
 
             attributeEditor->BuildUI(layout, row, occupyRow);
 
-            LoadAttributeValues(i, values);
-            attributeEditor->SetValues(values);
+            UpdateAttributeEditor(i, true);
             attributeEditor->onChanged_ = [=]()
             {
                 if (!applyOnCommit)
@@ -222,15 +222,44 @@ void MultipleSerializableInspector::BuildUI(AbstractLayout* layout)
 
 void MultipleSerializableInspector::Refresh()
 {
-    Vector<Variant> values;
     for (unsigned i = 0; i < attributeEditors_.Size(); ++i)
     {
-        if (AttributeEditor* attributeEditor = attributeEditors_[i])
-        {
-            LoadAttributeValues(i, values);
-            attributeEditor->SetValues(values);
-        }
+        if (attributeEditors_[i])
+            UpdateAttributeEditor(i, false);
+    }
+}
+
+String MultipleSerializableInspector::GetLayoutKey() const
+{
+    if (objects_.Empty() || !objects_[0]->GetAttributes())
+        return String::EMPTY;
+
+    // UI depends on object type, attribute set and label length
+    String key = objects_[0]->GetTypeName();
+    key += ";";
+    key += String(maxLabelLength_);
+    for (const AttributeInfo& attributeInfo : *objects_[0]->GetAttributes())
+    {
+        key += ";";
+        key += attributeInfo.name_;
+        key += ":";
+        key += Variant::GetTypeName(attributeInfo.type_);
     }
+    return key;
+}
+
+bool MultipleSerializableInspector::Rebind(Inspectable* source)
+{
+    auto other = dynamic_cast<MultipleSerializableInspector*>(source);
+    if (!other || other->objectType_ != objectType_ || other->metadataInjector_ != metadataInjector_)
+        return false;
+
+    objects_ = other->objects_;
+    undoStack_ = other->undoStack_;
+
+    // Editors that already show the same values are skipped
+    Refresh();
+    return true;
 }
 
 SharedPtr<AttributeEditor> MultipleSerializableInspector::CreateAttributeEditor(
@@ -275,6 +304,18 @@ void MultipleSerializableInspector::StoreAttributeValues(unsigned attributeIndex
         objects_[i]->SetAttribute(attributeIndex, values[i]);
 }
 
+void MultipleSerializableInspector::UpdateAttributeEditor(unsigned attributeIndex, bool forceUpdate)
+{
+    // Editor widgets are expensive to update, so skip attributes that are not changed
+    LoadAttributeValues(attributeIndex, attributeValues_);
+    Vector<Variant>& editorValues = editorValues_[attributeIndex];
+    if (!forceUpdate && editorValues == attributeValues_)
+        return;
+
+    editorValues = attributeValues_;
+    attributeEditors_[attributeIndex]->SetValues(editorValues);
+}
+
 void MultipleSerializableInspector::HandleAttributeChanged(unsigned attributeIndex)
 {
     AttributeEditor* attributeEditor = attributeEditors_[attributeIndex];
@@ -283,18 +324,33 @@ void MultipleSerializableInspector::HandleAttributeChanged(unsigned attributeInd
 
     // Update serializable attribute values
     LoadAttributeValues(attributeIndex, attributeValues_);
-    attributeEditor->GetValues(attributeValues_);
-    StoreAttributeValues(attributeIndex, attributeValues_);
+    if (undoStack_)
+    {
+        const Vector<Variant> oldValues = attributeValues_;
+        attributeEditor->GetValues(attributeValues_);
+        undoStack_->Push(MakeShared<EditAttributeCommand>(context_, objects_, attributeIndex, oldValues, attributeValues_));
+    }
+    else
+    {
+        attributeEditor->GetValues(attributeValues_);
+        StoreAttributeValues(attributeIndex, attributeValues_);
+    }
 
     // Update values in UI
-    LoadAttributeValues(attributeIndex, attributeValues_);
-    attributeEditor->SetValues(attributeValues_);
+    UpdateAttributeEditor(attributeIndex, true);
+
+    // Edited attribute may move objects, so cached scene state is invalid
+    SendEvent(E_EDITORATTRIBUTESCHANGED);
 }
 
 void MultipleSerializableInspector::HandleAttribureCommitted(unsigned attributeIndex)
 {
     if (!attributeEditors_[attributeIndex])
         return;
+
+    // Next edit is a new command
+    if (undoStack_)
+        undoStack_->BreakMerge();
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -308,6 +364,11 @@ void MultipleSerializableInspectorPanel::SetMetadataInjector(const SharedPtr<Att
     content_.SetMetadataInjector(metadataInjector);
 }
 
+void MultipleSerializableInspectorPanel::SetUndoStack(UndoStack* undoStack)
+{
+    content_.SetUndoStack(undoStack);
+}
+
 bool MultipleSerializableInspectorPanel::AddObject(Serializable* object)
 {
     return content_.AddObject(object);
@@ -330,6 +391,12 @@ void MultipleSerializableInspectorPanel::Refresh()
     content_.Refresh();
 }
 
+bool MultipleSerializableInspectorPanel::Rebind(InspectablePanel* source)
+{
+    auto other = dynamic_cast<MultipleSerializableInspectorPanel*>(source);
+    return other && content_.Rebind(&other->content_);
+}
+
 //////////////////////////////////////////////////////////////////////////
 void MultiplePanelInspectable::AddPanel(const SharedPtr<InspectablePanel>& panel)
 {
@@ -354,24 +421,106 @@ void MultiplePanelInspectable::Refresh()
         panel->Refresh();
 }
 
+String MultiplePanelInspectable::GetLayoutKey() const
+{
+    String key;
+    for (InspectablePanel* panel : panels_)
+    {
+        const String panelKey = panel->GetLayoutKey();
+        if (panelKey.Empty())
+            return String::EMPTY;
+        key += panelKey;
+        key += "\n";
+    }
+    return key;
+}
+
+bool MultiplePanelInspectable::Rebind(Inspectable* source)
+{
+    auto other = dynamic_cast<MultiplePanelInspectable*>(source);
+    if (!other || other->panels_.Size() != panels_.Size())
+        return false;
+
+    for (unsigned i = 0; i < panels_.Size(); ++i)
+    {
+        if (!panels_[i]->Rebind(other->panels_[i]))
+            return false;
+    }
+    return true;
+}
+
 //////////////////////////////////////////////////////////////////////////
 Inspector::Inspector(AbstractMainWindow* mainWindow)
     : Object(mainWindow->GetContext())
 {
     dialog_ = mainWindow->AddDock(DockLocation::Right, IntVector2(350, 350));
     dialog_->SetName("Inspector");
-    scrollRegion_ = dialog_->CreateContent<AbstractScrollArea>();
-    layout_ = scrollRegion_->CreateContent<AbstractLayout>();
+    stack_ = dialog_->CreateContent<AbstractWidgetStack>();
 }
 
 void Inspector::SetInspectable(const SharedPtr<Inspectable>& inspectable)
 {
+    // Previous UI that cannot be reused is removed
+    if (uncachedInspectable_)
+    {
+        stack_->RemoveChild(uncachedInspectable_);
+        uncachedInspectable_.Reset();
+    }
+
     inspectable_ = inspectable;
-    layout_->RemoveAllChildren();
     if (inspectable_)
-        inspectable_->BuildUI(layout_);
+    {
+        const String layoutKey = inspectable_->GetLayoutKey();
+        if (layoutKey.Empty())
+        {
+            uncachedInspectable_ = inspectable_;
+            BuildInspectableUI(inspectable_);
+        }
+        else
+        {
+            auto iter = cachedLayouts_.Find(layoutKey);
+            if (iter != cachedLayouts_.End() && iter->second_.inspectable_->Rebind(inspectable_))
+                inspectable_ = iter->second_.inspectable_;
+            else
+            {
+                if (iter != cachedLayouts_.End())
+                {
+                    stack_->RemoveChild(iter->second_.inspectable_);
+                    cachedLayouts_.Erase(iter);
+                }
+                EvictLayouts();
+                cachedLayouts_[layoutKey].inspectable_ = inspectable_;
+                BuildInspectableUI(inspectable_);
+            }
+            cachedLayouts_[layoutKey].lastUse_ = ++useCounter_;
+        }
+    }
+
+    stack_->SelectChild(inspectable_);
+}
+
+void Inspector::BuildInspectableUI(Inspectable* inspectable)
+{
+    auto scrollRegion = stack_->CreateChild<AbstractScrollArea>(inspectable);
+    AbstractLayout* layout = scrollRegion->CreateContent<AbstractLayout>();
+    inspectable->BuildUI(layout);
 }
 
+void Inspector::EvictLayouts()
+{
+    while (cachedLayouts_.Size() >= maxCachedLayouts_)
+    {
+        auto oldest = cachedLayouts_.Begin();
+        for (auto iter = cachedLayouts_.Begin(); iter != cachedLayouts_.End(); ++iter)
+        {
+            if (iter->second_.lastUse_ < oldest->second_.lastUse_)
+                oldest = iter;
+        }
+
+        stack_->RemoveChild(oldest->second_.inspectable_);
+        cachedLayouts_.Erase(oldest);
+    }
+}
 
 void Inspector::Refresh()
 {
@@ -379,4 +528,51 @@ void Inspector::Refresh()
         inspectable_->Refresh();
 }
 
+//////////////////////////////////////////////////////////////////////////
+EditAttributeCommand::EditAttributeCommand(Context* context, const PODVector<Serializable*>& objects, unsigned attributeIndex,
+    const Vector<Variant>& oldValues, const Vector<Variant>& newValues)
+    : UndoCommand(context)
+    , attributeIndex_(attributeIndex)
+    , oldValues_(oldValues)
+    , newValues_(newValues)
+{
+    for (Serializable* object : objects)
+        objects_.Push(WeakPtr<Serializable>(object));
+}
+
+void EditAttributeCommand::Undo() const
+{
+    ApplyValues(oldValues_);
+}
+
+void EditAttributeCommand::Redo() const
+{
+    ApplyValues(newValues_);
+}
+
+unsigned EditAttributeCommand::GetMemoryUse() const
+{
+    return sizeof(EditAttributeCommand) + objects_.Capacity() * sizeof(WeakPtr<Serializable>)
+        + (oldValues_.Capacity() + newValues_.Capacity()) * sizeof(Variant);
+}
+
+bool EditAttributeCommand::MergeWith(const UndoCommand& other)
+{
+    const auto* next = dynamic_cast<const EditAttributeCommand*>(&other);
+    if (!next || next->attributeIndex_ != attributeIndex_ || next->objects_ != objects_)
+        return false;
+
+    newValues_ = next->newValues_;
+    return true;
+}
+
+void EditAttributeCommand::ApplyValues(const Vector<Variant>& values) const
+{
+    for (unsigned i = 0; i < objects_.Size() && i < values.Size(); ++i)
+    {
+        if (Serializable* object = objects_[i])
+            object->SetAttribute(attributeIndex_, values[i]);
+    }
+}
+
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "UndoStack.h"
 #include "../AbstractUI/AbstractUI.h"
 
 namespace Urho3D
@@ -51,6 +52,10 @@ public:
     Inspectable(Context* context) : Object(context) { }
     virtual void BuildUI(AbstractLayout* layout) = 0;
     virtual void Refresh() = 0;
+    /// Return key of built UI. Inspectables with equal keys build the same UI. UI is not reused if empty.
+    virtual String GetLayoutKey() const { return String::EMPTY; }
+    /// Take inspected objects from inspectable with the same layout key. Built UI is kept.
+    virtual bool Rebind(Inspectable* source) { return false; }
 
 };
 
@@ -108,6 +113,7 @@ public:
 
     void SetMaxLabelLength(unsigned maxLength) { maxLabelLength_ = maxLength; }
     void SetMetadataInjector(const SharedPtr<AttributeMetadataInjector>& metadataInjector) { metadataInjector_ = metadataInjector; }
+    void SetUndoStack(UndoStack* undoStack) { undoStack_ = undoStack; }
 
     bool AddObject(Serializable* object);
     const PODVector<Serializable*>& GetObjects() const { return objects_; }
@@ -115,22 +121,29 @@ public:
 
     void BuildUI(AbstractLayout* layout) override;
     void Refresh() override;
+    String GetLayoutKey() const override;
+    bool Rebind(Inspectable* source) override;
 
 private:
     SharedPtr<AttributeEditor> CreateAttributeEditor(unsigned attributeIndex, const AttributeInfo& attributeInfo);
     const Variant& GetAttributeMetadata(StringHash objectType, const AttributeInfo& attributeInfo, StringHash metadataKey);
     void LoadAttributeValues(unsigned attributeIndex, Vector<Variant>& values);
     void StoreAttributeValues(unsigned attributeIndex, const Vector<Variant>& values);
+    /// Load attribute values and push them to editor if changed since last update.
+    void UpdateAttributeEditor(unsigned attributeIndex, bool forceUpdate);
     void HandleAttributeChanged(unsigned attributeIndex);
     void HandleAttribureCommitted(unsigned attributeIndex);
 
 private:
     unsigned maxLabelLength_ = M_MAX_UNSIGNED;
     SharedPtr<AttributeMetadataInjector> metadataInjector_;
+    WeakPtr<UndoStack> undoStack_;
 
     PODVector<Serializable*> objects_;
     StringHash objectType_;
     Vector<SharedPtr<AttributeEditor>> attributeEditors_;
+    /// Values shown by attribute editors.
+    Vector<Vector<Variant>> editorValues_;
 
     Vector<Variant> attributeValues_;
 };
@@ -144,6 +157,10 @@ public:
 
     virtual void BuildUI(AbstractCollapsiblePanel* panel) = 0;
     virtual void Refresh() = 0;
+    /// Return key of built UI. UI is not reused if empty.
+    virtual String GetLayoutKey() const { return String::EMPTY; }
+    /// Take inspected objects from panel with the same layout key.
+    virtual bool Rebind(InspectablePanel* source) { return false; }
 };
 
 class MultipleSerializableInspectorPanel : public InspectablePanel
@@ -155,11 +172,14 @@ public:
 
     void SetMaxLabelLength(unsigned maxLength);
     void SetMetadataInjector(const SharedPtr<AttributeMetadataInjector>& metadataInjector);
+    void SetUndoStack(UndoStack* undoStack);
 
     bool AddObject(Serializable* object);
 
     void BuildUI(AbstractCollapsiblePanel* panel) override;
     void Refresh() override;
+    String GetLayoutKey() const override { return content_.GetLayoutKey(); }
+    bool Rebind(InspectablePanel* source) override;
 
 private:
     MultipleSerializableInspector content_;
@@ -178,6 +198,8 @@ public:
 
     void BuildUI(AbstractLayout* layout) override;
     void Refresh() override;
+    String GetLayoutKey() const override;
+    bool Rebind(Inspectable* source) override;
 
 private:
     Vector<SharedPtr<InspectablePanel>> panels_;
@@ -189,15 +211,71 @@ class Inspector : public Object
 
 public:
     Inspector(AbstractMainWindow* mainWindow);
+    /// Set maximum number of inspector layouts kept for reuse.
+    void SetMaxCachedLayouts(unsigned maxCachedLayouts) { maxCachedLayouts_ = Max(1u, maxCachedLayouts); }
+    /// Set inspectable. UI built for inspectable with the same layout key is reused.
     void SetInspectable(const SharedPtr<Inspectable>& inspectable);
     void Refresh();
 
+private:
+    /// Inspectable whose UI is kept for reuse.
+    struct CachedLayout
+    {
+        /// Inspectable that owns the UI.
+        SharedPtr<Inspectable> inspectable_;
+        /// Time of last use.
+        unsigned lastUse_ = 0;
+    };
+
+    /// Build UI of inspectable in new stack page.
+    void BuildInspectableUI(Inspectable* inspectable);
+    /// Remove least recently used layouts until there is room for a new one.
+    void EvictLayouts();
+
 private:
     AbstractDock* dialog_ = nullptr;
-    AbstractScrollArea* scrollRegion_ = nullptr;
-    AbstractLayout* layout_ = nullptr;
+    AbstractWidgetStack* stack_ = nullptr;
 
     SharedPtr<Inspectable> inspectable_;
+    /// Inspectable with empty layout key, its UI is removed when replaced.
+    SharedPtr<Inspectable> uncachedInspectable_;
+    /// Cached layouts by layout key.
+    HashMap<String, CachedLayout> cachedLayouts_;
+    /// Maximum number of cached layouts.
+    unsigned maxCachedLayouts_ = 16;
+    /// Counter of layout uses.
+    unsigned useCounter_ = 0;
+};
+
+/// Attribute of multiple serializables edited. Consecutive edits of the same attribute are merged.
+class EditAttributeCommand : public UndoCommand
+{
+    URHO3D_OBJECT(EditAttributeCommand, UndoCommand);
+
+public:
+    /// Merge ID.
+    static const int MERGE_ID = 1;
+
+    /// Construct.
+    EditAttributeCommand(Context* context, const PODVector<Serializable*>& objects, unsigned attributeIndex,
+        const Vector<Variant>& oldValues, const Vector<Variant>& newValues);
+
+    void Undo() const override;
+    void Redo() const override;
+    String GetTitle() override { return "Edit Attribute"; }
+    unsigned GetMemoryUse() const override;
+    int GetMergeId() const override { return MERGE_ID; }
+    bool MergeWith(const UndoCommand& other) override;
+
+private:
+    /// Apply values.
+    void ApplyValues(const Vector<Variant>& values) const;
+
+private:
+    Vector<WeakPtr<Serializable>> objects_;
+    unsigned attributeIndex_;
+    Vector<Variant> oldValues_;
+    Vector<Variant> newValues_;
 };
 
 }
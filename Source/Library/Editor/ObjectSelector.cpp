@@ -1,19 +1,55 @@
 #include "ObjectSelector.h"
+#include "IdBufferPicker.h"
 #include "Selection.h"
 #include "../AbstractUI/AbstractInput.h"
 #include "../AbstractUI/KeyBinding.h"
 #include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/DebugRenderer.h>
 #include <Urho3D/Graphics/Octree.h>
 #include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SceneEvents.h>
 #include <Urho3D/Physics/PhysicsWorld.h>
 #include <Urho3D/Physics/RigidBody.h>
 
 namespace Urho3D
 {
 
+/// Return drawable flags for selection mode.
+static unsigned GetDrawableFlags(ObjectSelectionMode selectionMode)
+{
+    switch (selectionMode)
+    {
+    case ObjectSelectionMode::Lights:
+        return DRAWABLE_LIGHT;
+    case ObjectSelectionMode::Zones:
+        return DRAWABLE_ZONE;
+    default:
+        return DRAWABLE_GEOMETRY;
+    }
+}
+
 void ObjectSelector::SetScene(Scene* scene)
 {
+    if (scene_)
+    {
+        UnsubscribeFromEvent(scene_, E_NODEADDED);
+        UnsubscribeFromEvent(scene_, E_NODEREMOVED);
+        UnsubscribeFromEvent(scene_, E_COMPONENTADDED);
+        UnsubscribeFromEvent(scene_, E_COMPONENTREMOVED);
+        UnsubscribeFromEvent(scene_, E_NODEENABLEDCHANGED);
+        UnsubscribeFromEvent(scene_, E_COMPONENTENABLEDCHANGED);
+    }
     scene_ = scene;
+    if (scene_)
+    {
+        SubscribeToEvent(scene_, E_NODEADDED, URHO3D_HANDLER(ObjectSelector, HandleSceneChanged));
+        SubscribeToEvent(scene_, E_NODEREMOVED, URHO3D_HANDLER(ObjectSelector, HandleSceneChanged));
+        SubscribeToEvent(scene_, E_COMPONENTADDED, URHO3D_HANDLER(ObjectSelector, HandleSceneChanged));
+        SubscribeToEvent(scene_, E_COMPONENTREMOVED, URHO3D_HANDLER(ObjectSelector, HandleSceneChanged));
+        SubscribeToEvent(scene_, E_NODEENABLEDCHANGED, URHO3D_HANDLER(ObjectSelector, HandleSceneChanged));
+        SubscribeToEvent(scene_, E_COMPONENTENABLEDCHANGED, URHO3D_HANDLER(ObjectSelector, HandleSceneChanged));
+    }
+    pickCached_ = false;
 }
 
 void ObjectSelector::SetSelection(Selection* selection)
@@ -21,6 +57,25 @@ void ObjectSelector::SetSelection(Selection* selection)
     selection_ = selection;
 }
 
+void ObjectSelector::SetRaycastLevel(RayQueryLevel raycastLevel)
+{
+    raycastLevel_ = raycastLevel;
+    if (idBufferPicker_)
+        idBufferPicker_->SetBoundingBoxesOnly(raycastLevel_ == RAY_AABB);
+    MarkSceneChanged();
+}
+
+void ObjectSelector::SetPickingMethod(ObjectPickingMethod pickingMethod)
+{
+    pickingMethod_ = pickingMethod;
+    if (pickingMethod_ == ObjectPickingMethod::IdBuffer && !idBufferPicker_)
+    {
+        idBufferPicker_ = MakeShared<IdBufferPicker>(context_);
+        idBufferPicker_->SetBoundingBoxesOnly(raycastLevel_ == RAY_AABB);
+    }
+    MarkSceneChanged();
+}
+
 void ObjectSelector::SetControls(const Controls& controls)
 {
     controls_ = controls;
@@ -33,10 +88,109 @@ void ObjectSelector::AddSelectionTransferring(const String& sourceType, const St
 
 void ObjectSelector::PostRenderUpdate(AbstractInput& input, AbstractEditorContext& editorContext)
 {
-    if (scene_ && selection_ && !input.IsUIHovered())
+    if (!scene_ || !selection_)
+        return;
+
+    // Rectangle selection may be continued over UI
+    if (UpdateMarquee(input, editorContext))
+        return;
+
+    if (!input.IsUIHovered())
         PerformRaycast(input, editorContext);
 }
 
+bool ObjectSelector::UpdateMarquee(AbstractInput& input, AbstractEditorContext& editorContext)
+{
+    if (marqueeControl_ < 0)
+        return false;
+
+    const IntVector2 mousePosition = input.GetMousePosition();
+    const IntRect screenRect(
+        Min(marqueeStart_.x_, mousePosition.x_), Min(marqueeStart_.y_, mousePosition.y_),
+        Max(marqueeStart_.x_, mousePosition.x_), Max(marqueeStart_.y_, mousePosition.y_));
+
+    // Start rectangle selection when mouse is dragged far enough
+    if (!marqueeActive_ && (screenRect.Width() >= marqueeThreshold_ || screenRect.Height() >= marqueeThreshold_))
+        marqueeActive_ = true;
+
+    if (controls_[marqueeControl_].IsDown(input))
+    {
+        if (marqueeActive_)
+            DrawMarquee(screenRect, editorContext);
+        return marqueeActive_;
+    }
+
+    // Control is released
+    const bool wasActive = marqueeActive_;
+    if (marqueeActive_ && screenRect.Width() > 0 && screenRect.Height() > 0)
+        PerformMarqueeSelection(screenRect, editorContext);
+    marqueeControl_ = -1;
+    marqueeActive_ = false;
+    return wasActive;
+}
+
+void ObjectSelector::PerformMarqueeSelection(const IntRect& screenRect, AbstractEditorContext& editorContext)
+{
+    Octree* octree = scene_->GetComponent<Octree>();
+    if (!octree || selectionMode_ == ObjectSelectionMode::UI)
+        return;
+
+    // Rigid bodies are picked via geometries of their nodes
+    PODVector<Drawable*> result;
+    if (pickingMethod_ == ObjectPickingMethod::IdBuffer)
+    {
+        // Only visible objects are selected
+        UpdateIdBufferPicker(editorContext);
+        idBufferPicker_->GetDrawables(screenRect, result);
+    }
+    else
+    {
+        const Frustum frustum = editorContext.GetScreenRectFrustum(screenRect);
+        FrustumOctreeQuery query(result, frustum, GetDrawableFlags(selectionMode_), 0x7fffffff);
+        octree->GetDrawables(query);
+    }
+
+    // Don't mix nodes and components, like single object selection does
+    const bool selectNodes = marqueeControl_ == SELECT_NODE || marqueeControl_ == TOGGLE_NODE;
+    const bool clearSelection = marqueeControl_ == SELECT_NODE || marqueeControl_ == SELECT_COMPONENT
+        || (marqueeControl_ == TOGGLE_NODE && !selection_->GetComponents().Empty())
+        || (marqueeControl_ == TOGGLE_COMPONENT && !selection_->GetNodes().Empty());
+
+    SelectionChangeScope changeScope(selection_);
+    if (clearSelection)
+        selection_->ClearSelection();
+    for (Drawable* drawable : result)
+    {
+        if (Component* component = ResolveDrawable(drawable))
+        {
+            Object* object = selectNodes ? static_cast<Object*>(component->GetNode()) : component;
+            selection_->SelectObject(object, SelectionAction::Select, false);
+        }
+    }
+}
+
+void ObjectSelector::DrawMarquee(const IntRect& screenRect, AbstractEditorContext& editorContext)
+{
+    DebugRenderer* debug = scene_->GetComponent<DebugRenderer>();
+    if (!debug)
+        return;
+
+    // Draw rectangle in the middle of the frustum to keep it inside clip range
+    const Frustum frustum = editorContext.GetScreenRectFrustum(screenRect);
+    Vector3 corners[4];
+    for (unsigned i = 0; i < 4; ++i)
+        corners[i] = frustum.vertices_[i].Lerp(frustum.vertices_[i + 4], 0.5f);
+    for (unsigned i = 0; i < 4; ++i)
+        debug->AddLine(corners[i], corners[(i + 1) % 4], Color::WHITE, false);
+}
+
+Component* ObjectSelector::ResolveDrawable(Drawable* drawable)
+{
+    if (selectionMode_ == ObjectSelectionMode::Rigidbodies)
+        return drawable->GetNode()->GetComponent<RigidBody>();
+    return ResolveRoutine(drawable);
+}
+
 void ObjectSelector::PerformRaycast(AbstractInput& input, AbstractEditorContext& editorContext)
 {
 #if 0
@@ -63,59 +217,33 @@ void ObjectSelector::PerformRaycast(AbstractInput& input, AbstractEditorContext&
 
     // Pick component
     Component* selectedComponent = nullptr;
-    if (selectionMode_ == ObjectSelectionMode::Rigidbodies)
-    {
-        PhysicsWorld* physicsWorld = scene_->GetComponent<PhysicsWorld>();
-        if (!physicsWorld)
-            return;
-
-        // If we are not running the actual physics update, refresh collisions before raycasting
-        //if (!runUpdate) #TODO Fixme
-        physicsWorld->UpdateCollisions();
-
-        PhysicsRaycastResult result;
-        physicsWorld->RaycastSingle(result, editorContext.GetMouseRay(), editorContext.GetCurrentCamera()->GetFarClip());
-        if (result.body_)
-            selectedComponent = result.body_;
-    }
-    else
-    {
-        Octree* octree = scene_->GetComponent<Octree>();
-        if (!octree)
-            return;
-
-        static int pickModeDrawableFlags[3] = { DRAWABLE_GEOMETRY, DRAWABLE_LIGHT, DRAWABLE_ZONE };
-        PODVector<RayQueryResult> result;
-        RayOctreeQuery query(result, editorContext.GetMouseRay(), RAY_TRIANGLE, editorContext.GetCurrentCamera()->GetFarClip(),
-            pickModeDrawableFlags[static_cast<int>(selectionMode_)], 0x7fffffff);
-        octree->RaycastSingle(query);
-
-        if (!result.Empty())
-        {
-            Drawable* drawable = result[0].drawable_;
-            selectedComponent = ResolveRoutine(drawable);
-        }
-    }
+    if (!PickComponent(input, editorContext, selectedComponent))
+        return;
 
     // Hover object
     selection_->SetHoveredObject(selectedComponent);
 
     // Preform selection
-    if (selectedComponent)
+    if (controls_[TOGGLE_COMPONENT].IsPressed(input))
     {
-        if (controls_[TOGGLE_COMPONENT].IsPressed(input))
+        if (selectedComponent)
         {
             // Clear selection if there are nodes in existing selection
             const bool clearSelection = !selection_->GetNodes().Empty();
             selection_->SelectObject(selectedComponent, SelectionAction::Toggle, clearSelection);
         }
+        StartMarquee(TOGGLE_COMPONENT, input);
+    }
 
-        if (controls_[TOGGLE_NODE].IsPressed(input))
+    if (controls_[TOGGLE_NODE].IsPressed(input))
+    {
+        if (selectedComponent)
         {
             // Clear selection if there are nodes in existing selection
             const bool clearSelection = !selection_->GetComponents().Empty();
             selection_->SelectObject(selectedComponent->GetNode(), SelectionAction::Toggle, clearSelection);
         }
+        StartMarquee(TOGGLE_NODE, input);
     }
 
     if (controls_[SELECT_COMPONENT].IsPressed(input))
@@ -124,6 +252,7 @@ void ObjectSelector::PerformRaycast(AbstractInput& input, AbstractEditorContext&
             selection_->SelectObject(selectedComponent, SelectionAction::Select, true);
         else
             selection_->ClearSelection();
+        StartMarquee(SELECT_COMPONENT, input);
     }
 
     if (controls_[SELECT_NODE].IsPressed(input))
@@ -132,7 +261,108 @@ void ObjectSelector::PerformRaycast(AbstractInput& input, AbstractEditorContext&
             selection_->SelectObject(selectedComponent->GetNode(), SelectionAction::Select, true);
         else
             selection_->ClearSelection();
+        StartMarquee(SELECT_NODE, input);
+    }
+}
+
+void ObjectSelector::StartMarquee(Control control, AbstractInput& input)
+{
+    marqueeControl_ = control;
+    marqueeActive_ = false;
+    marqueeStart_ = input.GetMousePosition();
+}
+
+bool ObjectSelector::PickComponent(AbstractInput& input, AbstractEditorContext& editorContext, Component*& component)
+{
+    Camera* camera = editorContext.GetCurrentCamera();
+    const IntVector2 mousePosition = input.GetMousePosition();
+    const Matrix3x4 cameraView = camera->GetView();
+    const Matrix4 cameraProjection = camera->GetProjection();
+
+    // Running scene may change at any moment
+    const bool sceneChanged = scene_->IsUpdateEnabled() || pickSceneRevision_ != sceneRevision_;
+    if (pickCached_ && !sceneChanged && pickMousePosition_ == mousePosition
+        && pickCameraView_ == cameraView && pickCameraProjection_ == cameraProjection)
+    {
+        component = pickedComponent_;
+        return true;
     }
+
+    // ID buffer is rebuilt on every camera change, so it's not used until camera stops
+    const bool cameraSettled = pickCameraView_ == cameraView && pickCameraProjection_ == cameraProjection;
+    pickCached_ = DoPickComponent(mousePosition, editorContext, cameraSettled, component);
+    pickMousePosition_ = mousePosition;
+    pickCameraView_ = cameraView;
+    pickCameraProjection_ = cameraProjection;
+    pickSceneRevision_ = sceneRevision_;
+    pickedComponent_ = component;
+    return pickCached_;
+}
+
+bool ObjectSelector::DoPickComponent(const IntVector2& mousePosition, AbstractEditorContext& editorContext, bool allowIdBuffer,
+    Component*& component)
+{
+    component = nullptr;
+    if (selectionMode_ == ObjectSelectionMode::Rigidbodies)
+    {
+        PhysicsWorld* physicsWorld = scene_->GetComponent<PhysicsWorld>();
+        if (!physicsWorld)
+            return false;
+
+        // If we are not running the actual physics update, refresh collisions before raycasting
+        if (!scene_->IsUpdateEnabled())
+            physicsWorld->UpdateCollisions();
+
+        PhysicsRaycastResult result;
+        physicsWorld->RaycastSingle(result, editorContext.GetMouseRay(), editorContext.GetCurrentCamera()->GetFarClip());
+        if (result.body_)
+            component = result.body_;
+    }
+    else if (pickingMethod_ == ObjectPickingMethod::IdBuffer && allowIdBuffer)
+    {
+        if (!UpdateIdBufferPicker(editorContext))
+            return false;
+
+        if (Drawable* drawable = idBufferPicker_->GetDrawable(mousePosition))
+            component = ResolveRoutine(drawable);
+    }
+    else
+    {
+        Octree* octree = scene_->GetComponent<Octree>();
+        if (!octree)
+            return false;
+
+        PODVector<RayQueryResult> result;
+        RayOctreeQuery query(result, editorContext.GetMouseRay(), raycastLevel_, editorContext.GetCurrentCamera()->GetFarClip(),
+            GetDrawableFlags(selectionMode_), 0x7fffffff);
+        octree->RaycastSingle(query);
+
+        if (!result.Empty())
+        {
+            Drawable* drawable = result[0].drawable_;
+            component = ResolveRoutine(drawable);
+        }
+    }
+    return true;
+}
+
+bool ObjectSelector::UpdateIdBufferPicker(AbstractEditorContext& editorContext)
+{
+    Octree* octree = scene_->GetComponent<Octree>();
+    if (!octree)
+        return false;
+
+    // Running scene may change at any moment
+    if (scene_->IsUpdateEnabled())
+        idBufferPicker_->Invalidate();
+    idBufferPicker_->Update(octree, editorContext.GetCurrentCamera(), editorContext.GetCurrentViewportRect(),
+        GetDrawableFlags(selectionMode_), sceneRevision_);
+    return true;
+}
+
+void ObjectSelector::HandleSceneChanged(StringHash eventType, VariantMap& eventData)
+{
+    MarkSceneChanged();
 }
 
 Component* ObjectSelector::ResolveRoutine(Component* source)
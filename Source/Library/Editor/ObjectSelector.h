@@ -1,6 +1,7 @@
 #pragma once
 
 #include "EditorInterfaces.h"
+#include <Urho3D/Graphics/OctreeQuery.h>
 
 namespace Urho3D
 {
@@ -9,6 +10,8 @@ class Selection;
 class Component;
 class Scene;
 class CompositeKeyBinding;
+class Drawable;
+class IdBufferPicker;
 
 /// Object pick mode.
 enum class ObjectSelectionMode
@@ -25,6 +28,16 @@ enum class ObjectSelectionMode
     UI
 };
 
+/// Object picking method.
+enum class ObjectPickingMethod
+{
+    /// Raycast octree or physics world.
+    Raycast,
+    /// Look up buffer of drawable IDs. Buffer is rebuilt only when camera or scene is changed.
+    /// Hover picking falls back to raycast while camera is moving.
+    IdBuffer
+};
+
 /// Performs raycast and object picking.
 class ObjectSelector : public AbstractEditorOverlay
 {
@@ -49,7 +62,17 @@ public:
     /// Set controls.
     void SetControls(const Controls& controls);
     /// Set selection mode.
-    void SetSelectionMode(ObjectSelectionMode selectionMode) { selectionMode_ = selectionMode; }
+    void SetSelectionMode(ObjectSelectionMode selectionMode) { selectionMode_ = selectionMode; MarkSceneChanged(); }
+    /// Set raycast level. Bounding box level is cheaper but less precise.
+    void SetRaycastLevel(RayQueryLevel raycastLevel);
+    /// Set picking method. Rigid bodies are always picked via raycast.
+    void SetPickingMethod(ObjectPickingMethod pickingMethod);
+    /// Return picking method.
+    ObjectPickingMethod GetPickingMethod() const { return pickingMethod_; }
+    /// Notify that scene was changed and cached pick result is no longer valid.
+    void MarkSceneChanged() { ++sceneRevision_; }
+    /// Set minimal mouse movement in pixels that starts rectangle selection.
+    void SetMarqueeThreshold(int threshold) { marqueeThreshold_ = threshold; }
     /// Add selection transferring routine.
     void AddSelectionTransferring(const String& sourceType, const String& destType);
 
@@ -60,6 +83,24 @@ private:
 private:
     /// Perform raycast.
     void PerformRaycast(AbstractInput& input, AbstractEditorContext& editorContext);
+    /// Pick component under mouse, reuse cached result if possible. Return false if picking is impossible.
+    bool PickComponent(AbstractInput& input, AbstractEditorContext& editorContext, Component*& component);
+    /// Pick component under mouse. ID buffer is used only if allowed. Return false if picking is impossible.
+    bool DoPickComponent(const IntVector2& mousePosition, AbstractEditorContext& editorContext, bool allowIdBuffer, Component*& component);
+    /// Update ID buffer picker. Return false if there's no octree.
+    bool UpdateIdBufferPicker(AbstractEditorContext& editorContext);
+    /// Handle scene structure change.
+    void HandleSceneChanged(StringHash eventType, VariantMap& eventData);
+    /// Remember control and mouse position that may start rectangle selection.
+    void StartMarquee(Control control, AbstractInput& input);
+    /// Update rectangle selection. Return true if rectangle selection is in progress.
+    bool UpdateMarquee(AbstractInput& input, AbstractEditorContext& editorContext);
+    /// Select all objects inside screen rectangle.
+    void PerformMarqueeSelection(const IntRect& screenRect, AbstractEditorContext& editorContext);
+    /// Draw screen rectangle.
+    void DrawMarquee(const IntRect& screenRect, AbstractEditorContext& editorContext);
+    /// Return component picked via drawable.
+    Component* ResolveDrawable(Drawable* drawable);
     /// Resolve routine.
     Component* ResolveRoutine(Component* source);
 
@@ -74,6 +115,36 @@ private:
     ObjectSelectionMode selectionMode_ = ObjectSelectionMode::Geometries;
     /// Disabled components.
     HashMap<String, String> selectionTransferringRoutines_;
+    /// Raycast level.
+    RayQueryLevel raycastLevel_ = RAY_TRIANGLE;
+    /// Picking method.
+    ObjectPickingMethod pickingMethod_ = ObjectPickingMethod::Raycast;
+    /// ID buffer picker.
+    SharedPtr<IdBufferPicker> idBufferPicker_;
+
+    /// Scene revision, incremented on every known scene change.
+    unsigned sceneRevision_ = 0;
+    /// Whether the cached pick result is valid.
+    bool pickCached_ = false;
+    /// Mouse position of cached pick result.
+    IntVector2 pickMousePosition_;
+    /// Camera view of cached pick result.
+    Matrix3x4 pickCameraView_;
+    /// Camera projection of cached pick result.
+    Matrix4 pickCameraProjection_;
+    /// Scene revision of cached pick result.
+    unsigned pickSceneRevision_ = 0;
+    /// Cached picked component.
+    WeakPtr<Component> pickedComponent_;
+
+    /// Minimal mouse movement in pixels that starts rectangle selection.
+    int marqueeThreshold_ = 4;
+    /// Control that started rectangle selection.
+    int marqueeControl_ = -1;
+    /// Whether the rectangle selection is active.
+    bool marqueeActive_ = false;
+    /// Start point of rectangle selection.
+    IntVector2 marqueeStart_;
 
 };
 
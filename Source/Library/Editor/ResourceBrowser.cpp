@@ -1,21 +1,305 @@
 #include "ResourceBrowser.h"
 #include <Urho3D/Container/Sort.h>
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Technique.h>
+#include <Urho3D/IO/File.h>
 #include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/FileWatcher.h>
 #include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <sys/stat.h>
 
 namespace Urho3D
 {
 
-ResourceFileItem::ResourceFileItem(Context* context, ResourceFileDesc* file)
+namespace
+{
+
+/// Return index of the first element whose name is not less than given one. Elements shall be sorted by name.
+template <class T> unsigned FindFirstIndex(const Vector<SharedPtr<T>>& elements, const String& name)
+{
+    unsigned first = 0;
+    unsigned last = elements.Size();
+    while (first < last)
+    {
+        const unsigned middle = (first + last) / 2;
+        if (elements[middle]->name_ < name)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    return first;
+}
+
+/// Return index of the first element whose name is greater than given one. Elements shall be sorted by name.
+template <class T> unsigned FindInsertionIndex(const Vector<SharedPtr<T>>& elements, const String& name)
+{
+    unsigned first = 0;
+    unsigned last = elements.Size();
+    while (first < last)
+    {
+        const unsigned middle = (first + last) / 2;
+        if (name < elements[middle]->name_)
+            last = middle;
+        else
+            first = middle + 1;
+    }
+    return first;
+}
+
+/// Get size and modification time of file. Return false if file doesn't exist.
+bool GetFileStats(const String& fileName, unsigned& size, unsigned& modifiedTime)
+{
+#ifdef _WIN32
+    struct _stat st;
+    if (_wstat(WString(GetNativePath(fileName)).CString(), &st) != 0)
+        return false;
+#else
+    struct stat st;
+    if (stat(GetNativePath(fileName).CString(), &st) != 0)
+        return false;
+#endif
+    size = static_cast<unsigned>(st.st_size);
+    modifiedTime = static_cast<unsigned>(st.st_mtime);
+    return true;
+}
+
+/// Size of file header read for type recognition.
+const unsigned FILE_HEADER_SIZE = 4096;
+
+/// Find name of XML root element in the file header. Return false if header is insufficient or unrecognized.
+bool SniffXmlRootName(const String& header, String& rootName)
+{
+    // Skip UTF-8 byte order mark
+    unsigned position = header.StartsWith("\xEF\xBB\xBF") ? 3 : 0;
+    while (position < header.Length())
+    {
+        const char ch = header[position];
+        if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n')
+        {
+            ++position;
+            continue;
+        }
+
+        if (ch != '<')
+            return false;
+
+        // Skip declaration, processing instructions, comments and document type
+        unsigned end = String::NPOS;
+        if (header.Substring(position, 2) == "<?")
+            end = header.Find("?>", position + 2);
+        else if (header.Substring(position, 4) == "<!--")
+            end = header.Find("-->", position + 4);
+        else if (header.Substring(position, 2) == "<!")
+        {
+            // Internal subset of document type may contain tags
+            end = header.Find('>', position + 2);
+            if (end != String::NPOS && header.Find('[', position + 2) < end)
+                return false;
+        }
+        else
+        {
+            // Root element
+            end = position + 1;
+            while (end < header.Length() && !strchr(" \t\r\n/>", header[end]))
+                ++end;
+            if (end == header.Length() || end == position + 1)
+                return false;
+
+            rootName = header.Substring(position + 1, end - position - 1);
+            return true;
+        }
+
+        if (end == String::NPOS)
+            return false;
+        position = header.Find('>', end) + 1;
+    }
+    return false;
+}
+
+/// Version of type index file format.
+const unsigned TYPE_INDEX_VERSION = 4;
+
+/// Maximum length of resource name found in resource file.
+const unsigned MAX_RESOURCE_NAME_LENGTH = 512;
+
+/// Maximum length of extension of resource name found in resource file.
+const unsigned MAX_EXTENSION_LENGTH = 8;
+
+/// Return whether the string found in resource file looks like resource name.
+bool IsResourceName(const String& name)
+{
+    if (name.Length() < 3 || name.Length() > MAX_RESOURCE_NAME_LENGTH)
+        return false;
+
+    // Extension shall start with letter, so that numbers are not mistaken for names
+    const unsigned dot = name.FindLast('.');
+    if (dot == String::NPOS || dot == 0 || name.Length() - dot - 1 > MAX_EXTENSION_LENGTH)
+        return false;
+    if (!IsAlpha(static_cast<unsigned char>(name[dot + 1])))
+        return false;
+    for (unsigned i = dot + 1; i < name.Length(); ++i)
+    {
+        if (!IsAlpha(static_cast<unsigned char>(name[i])) && !IsDigit(static_cast<unsigned char>(name[i])))
+            return false;
+    }
+
+    for (unsigned i = 0; i < name.Length(); ++i)
+    {
+        if (strchr("<>\"|?*:\t\r\n", name[i]))
+            return false;
+    }
+    return true;
+}
+
+/// Add resource names referenced by XML element and its children.
+void ExtractXmlDependencies(const XMLElement& element, Vector<String>& dependencies)
+{
+    for (const String& attributeName : element.GetAttributeNames())
+    {
+        const String value = element.GetAttribute(attributeName);
+
+        // Shaders of technique passes are referenced by name and resolved for the active backend.
+        // Shader is added even if missing, so it is linked once created
+        if (attributeName == "vs" || attributeName == "ps")
+        {
+#ifdef URHO3D_OPENGL
+            dependencies.Push("Shaders/GLSL/" + value + ".glsl");
+#else
+            dependencies.Push("Shaders/HLSL/" + value + ".hlsl");
+#endif
+            continue;
+        }
+
+        // Resource references and lists are separated by semicolons
+        for (const String& token : value.Split(';'))
+        {
+            const String name = token.Trimmed();
+            if (IsResourceName(name))
+                dependencies.Push(name);
+        }
+    }
+
+    for (XMLElement child = element.GetChild(); child; child = child.GetNext())
+        ExtractXmlDependencies(child, dependencies);
+}
+
+/// Add resource names referenced by binary resource file.
+void ExtractBinaryDependencies(Context* context, Deserializer& source, Vector<String>& dependencies)
+{
+    // File is read in chunks. Unfinished printable run is carried over to the next chunk with the bytes before it.
+    static const unsigned chunkSize = 64 * 1024;
+    static const unsigned maxPrefixSize = 5;
+    static const unsigned maxRunLength = MAX_RESOURCE_NAME_LENGTH + maxPrefixSize;
+
+    // Resource reference is type hash followed by null-terminated name, reference list also has count before names.
+    // Bytes of hash and count may be printable, so name may start later than the printable run.
+    const auto& factories = context->GetObjectFactories();
+    PODVector<unsigned char> data;
+    auto isTypeAt = [&](unsigned position)
+    {
+        unsigned hash = 0;
+        memcpy(&hash, &data[position], sizeof(hash));
+        return factories.Contains(StringHash(hash));
+    };
+
+    bool previousAccepted = false;
+    bool skipRun = false;
+    unsigned begin = 0;
+    unsigned end = 0;
+    for (;;)
+    {
+        if (end == data.Size())
+        {
+            if (source.IsEof())
+                break;
+
+            // Runs too long to be names are skipped
+            if (end - begin > maxRunLength)
+            {
+                skipRun = true;
+                begin = end;
+            }
+
+            // Keep the run and bytes that may hold its type hash
+            const unsigned keepFrom = begin >= maxPrefixSize ? begin - maxPrefixSize : 0;
+            const unsigned keepSize = data.Size() - keepFrom;
+            if (keepSize > 0 && keepFrom > 0)
+                memmove(&data[0], &data[keepFrom], keepSize);
+            data.Resize(keepSize + chunkSize);
+            const unsigned readSize = source.Read(&data[keepSize], chunkSize);
+            data.Resize(keepSize + readSize);
+            begin -= keepFrom;
+            end -= keepFrom;
+            if (readSize == 0)
+                break;
+        }
+
+        // Names are printable, non-ASCII characters are allowed
+        const unsigned char ch = data[end];
+        if (ch >= 32 && ch != 127)
+        {
+            ++end;
+            continue;
+        }
+
+        bool accepted = false;
+        if (ch == 0 && end > begin && !skipRun)
+        {
+            // Names of reference list follow each other
+            if (previousAccepted)
+            {
+                const String name(reinterpret_cast<const char*>(&data[begin]), end - begin);
+                if (IsResourceName(name))
+                {
+                    dependencies.Push(name);
+                    accepted = true;
+                }
+            }
+
+            for (unsigned start = begin; !accepted && start < end && start <= begin + 5; ++start)
+            {
+                const bool hasType = (start >= 4 && isTypeAt(start - 4)) || (start >= 5 && isTypeAt(start - 5));
+                if (!hasType)
+                    continue;
+
+                const String name(reinterpret_cast<const char*>(&data[start]), end - start);
+                if (IsResourceName(name))
+                {
+                    dependencies.Push(name);
+                    accepted = true;
+                }
+            }
+        }
+
+        previousAccepted = accepted;
+        skipRun = false;
+        begin = ++end;
+    }
+}
+
+}
+
+ResourceFileItem::ResourceFileItem(Context* context, ResourceFileDesc* file, bool showResourceKey /*= false*/)
     : AbstractHierarchyListItem(context)
     , file_(file)
+    , showResourceKey_(showResourceKey)
 {
     file->item_ = this;
 }
 
 String ResourceFileItem::GetText()
 {
-    return file_->name_;
+    return showResourceKey_ ? file_->GetResourceName() : file_->name_;
+}
+
+Image* ResourceFileItem::GetImage()
+{
+    return thumbnails_ ? thumbnails_->GetThumbnail(*file_) : nullptr;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -77,6 +361,11 @@ ResourceType ExtensionResourceRecognitionLayer::ParseFileName(const String& exte
     return ResourceType::EMPTY;
 }
 
+unsigned ExtensionResourceRecognitionLayer::ToHash() const
+{
+    return StringHash("extension:" + extension_).Value() * 31 + type_.ToHash();
+}
+
 //////////////////////////////////////////////////////////////////////////
 BinaryResourceRecognitionLayer::BinaryResourceRecognitionLayer(
     const String& fileId, const String& resourceType, StringHash objectType /*= StringHash()*/)
@@ -92,6 +381,11 @@ ResourceType BinaryResourceRecognitionLayer::ParseFileID(const String& fileId)
     return ResourceType::EMPTY;
 }
 
+unsigned BinaryResourceRecognitionLayer::ToHash() const
+{
+    return StringHash("fileid:" + fileId_).Value() * 31 + type_.ToHash();
+}
+
 //////////////////////////////////////////////////////////////////////////
 XMLResourceRecognitionLayer::XMLResourceRecognitionLayer(
     const String& rootName, const String& resourceType, StringHash objectType /*= StringHash()*/)
@@ -107,6 +401,11 @@ ResourceType XMLResourceRecognitionLayer::ParseRootNode(const String& rootName)
     return ResourceType::EMPTY;
 }
 
+unsigned XMLResourceRecognitionLayer::ToHash() const
+{
+    return StringHash("root:" + rootName_).Value() * 31 + type_.ToHash();
+}
+
 //////////////////////////////////////////////////////////////////////////
 ResourceRecognitionLayerSPtr MakeExtensionLayer(const String& extension, const String& resourceType, StringHash objectType /*= StringHash()*/)
 {
@@ -149,10 +448,280 @@ ResourceRecognitionLayerArray MakeXmlLayers(const Vector<String>& rootNames, con
 }
 
 //////////////////////////////////////////////////////////////////////////
+ResourceTypeRecognizer::ResourceTypeRecognizer(Context* context,
+    const ResourceRecognitionLayerArray& layers, const HashSet<String>& xmlExtensions)
+    : context_(context)
+    , cache_(context->GetSubsystem<ResourceCache>())
+    , layers_(layers)
+    , xmlExtensions_(xmlExtensions)
+{
+    // Order of layers matters, order of extensions doesn't
+    signature_ = TYPE_INDEX_VERSION;
+    for (ResourceRecognitionLayer* layer : layers_)
+        signature_ = signature_ * 31 + layer->ToHash();
+    for (const String& extension : xmlExtensions_)
+        signature_ ^= StringHash(extension).Value();
+}
+
+ResourceType ResourceTypeRecognizer::GetResourceType(const String& resourceKey, const String& extension) const
+{
+    SharedPtr<File> file;
+    String header;
+    bool rootNodeLoaded = false;
+    String rootNode;
+
+    for (ResourceRecognitionLayer* layer : layers_)
+    {
+        // Try to parse file name
+        if (layer->CanParseFileName())
+        {
+            const ResourceType typeByName = layer->ParseFileName(extension, resourceKey);
+            if (!typeByName.IsEmpty())
+                return typeByName;
+        }
+
+        // Read file header once for both file ID and root node name
+        if (!file && (layer->CanParseFileID() || layer->CanParseRootNode()))
+        {
+            file = cache_->GetFile(resourceKey, false);
+            if (!file)
+                return ResourceType::EMPTY;
+
+            header.Resize(Min(file->GetSize(), FILE_HEADER_SIZE));
+            if (!header.Empty())
+                header.Resize(file->Read(&header[0], header.Length()));
+        }
+
+        // Try to parse file ID
+        if (layer->CanParseFileID())
+        {
+            const ResourceType typeById = layer->ParseFileID(header.Substring(0, 4));
+            if (!typeById.IsEmpty())
+                return typeById;
+        }
+
+        // Try to parse root node name
+        if (layer->CanParseRootNode() && xmlExtensions_.Contains(extension))
+        {
+            // Parse whole file only if root node is not in the header
+            if (!rootNodeLoaded)
+            {
+                rootNodeLoaded = true;
+                if (!SniffXmlRootName(header, rootNode))
+                {
+                    file->Seek(0);
+                    XMLFile xml(context_);
+                    xml.Load(*file);
+                    rootNode = xml.GetRoot().GetName();
+                }
+            }
+
+            const ResourceType xmlType = layer->ParseRootNode(rootNode);
+            if (!xmlType.IsEmpty())
+                return xmlType;
+        }
+    }
+    return ResourceType::EMPTY;
+}
+
+void ResourceTypeRecognizer::GetDependencies(const String& resourceKey, const String& extension,
+    const ResourceType& type, Vector<String>& dependencies) const
+{
+    // Only types that reference other resources are parsed, others like UI layouts may be big for nothing.
+    // Models don't reference other resources either and may be huge
+    const StringHash objectType = type.objectType_;
+    const bool isXml = xmlExtensions_.Contains(extension) && (objectType == Scene::GetTypeStatic()
+        || objectType == Node::GetTypeStatic() || objectType == Material::GetTypeStatic() || objectType == Technique::GetTypeStatic());
+    const bool isBinary = !isXml && objectType == Scene::GetTypeStatic();
+    if (!isXml && !isBinary)
+        return;
+
+    SharedPtr<File> file = cache_->GetFile(resourceKey, false);
+    if (!file)
+        return;
+
+    if (isXml)
+    {
+        XMLFile xml(context_);
+        if (xml.Load(*file))
+            ExtractXmlDependencies(xml.GetRoot(), dependencies);
+    }
+    else
+        ExtractBinaryDependencies(context_, *file, dependencies);
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool ResourceTypeIndex::Load(Context* context, const String& fileName)
+{
+    entries_.Clear();
+    if (!context->GetSubsystem<FileSystem>()->FileExists(fileName))
+        return false;
+
+    File file(context, fileName, FILE_READ);
+    if (!file.IsOpen() || file.ReadFileID() != "URTI" || file.ReadUInt() != signature_)
+        return false;
+
+    Vector<ResourceType> types(file.ReadVLE());
+    for (ResourceType& type : types)
+    {
+        type.objectType_ = file.ReadStringHash();
+        type.resourceType_ = file.ReadString();
+    }
+
+    const unsigned numEntries = file.ReadVLE();
+    for (unsigned i = 0; i < numEntries && !file.IsEof(); ++i)
+    {
+        const String entryFileName = file.ReadString();
+        Entry entry;
+        entry.size_ = file.ReadUInt();
+        entry.modifiedTime_ = file.ReadUInt();
+        const unsigned typeIndex = file.ReadVLE();
+        if (typeIndex >= types.Size())
+            break;
+
+        entry.type_ = types[typeIndex];
+        entry.dependencies_.Resize(file.ReadVLE());
+        for (String& dependency : entry.dependencies_)
+            dependency = file.ReadString();
+        entries_[entryFileName] = entry;
+    }
+
+    // Discard truncated index
+    if (entries_.Size() != numEntries)
+    {
+        entries_.Clear();
+        return false;
+    }
+    return true;
+}
+
+bool ResourceTypeIndex::Save(Context* context, const String& fileName) const
+{
+    // Types are stored once and referenced by index
+    Vector<ResourceType> types;
+    HashMap<ResourceType, unsigned> typeIndices;
+    for (const auto& item : entries_)
+    {
+        const ResourceType& type = item.second_.type_;
+        if (!typeIndices.Contains(type))
+        {
+            typeIndices[type] = types.Size();
+            types.Push(type);
+        }
+    }
+
+    File file(context, fileName, FILE_WRITE);
+    if (!file.IsOpen())
+        return false;
+
+    file.WriteFileID("URTI");
+    file.WriteUInt(signature_);
+
+    file.WriteVLE(types.Size());
+    for (const ResourceType& type : types)
+    {
+        file.WriteStringHash(type.objectType_);
+        file.WriteString(type.resourceType_);
+    }
+
+    file.WriteVLE(entries_.Size());
+    for (const auto& item : entries_)
+    {
+        const Entry& entry = item.second_;
+        file.WriteString(item.first_);
+        file.WriteUInt(entry.size_);
+        file.WriteUInt(entry.modifiedTime_);
+        file.WriteVLE(typeIndices[entry.type_]);
+        file.WriteVLE(entry.dependencies_.Size());
+        for (const String& dependency : entry.dependencies_)
+            file.WriteString(dependency);
+    }
+    return true;
+}
+
+bool ResourceTypeIndex::FindEntry(const String& fileName, unsigned size, unsigned modifiedTime, Entry& entry) const
+{
+    auto iter = entries_.Find(fileName);
+    if (iter == entries_.End() || iter->second_.size_ != size || iter->second_.modifiedTime_ != modifiedTime)
+        return false;
+
+    entry = iter->second_;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void ResourceScanTask::ScanResourceDirectory(const String& resourceDir, const String& directoryKey, unsigned resourceDirIndex)
+{
+    AddScannedDirectory(resourceDir, directoryKey, resourceDirIndex);
+
+    const String prefix = directoryKey.Empty() ? String::EMPTY : directoryKey + "/";
+    Vector<String> directories;
+    fileSystem_->ScanDir(directories, AddTrailingSlash(resourceDir) + directoryKey, "*.*", SCAN_DIRS, true);
+    for (const String& directory : directories)
+    {
+        if (cancelled_)
+            return;
+        if (directory.EndsWith("."))
+            continue;
+        AddScannedDirectory(resourceDir, prefix + directory, resourceDirIndex);
+    }
+}
+
+void ResourceScanTask::TakeScannedDirectories(Vector<ScannedResourceDirectory>& directories)
+{
+    MutexLock lock(mutex_);
+    directories.Push(scannedDirectories_);
+    scannedDirectories_.Clear();
+}
+
+String ResourceScanTask::GetFileName(const ResourceFileDesc& file) const
+{
+    return AddTrailingSlash(resourceDirs_[file.resourceDirIndex_]) + file.GetResourceName();
+}
+
+void ResourceScanTask::AddScannedDirectory(const String& resourceDir, const String& directoryKey, unsigned resourceDirIndex)
+{
+    ScannedResourceDirectory scannedDirectory;
+    scannedDirectory.directoryKey_ = directoryKey;
+    scannedDirectory.resourceDirIndex_ = resourceDirIndex;
+    fileSystem_->ScanDir(scannedDirectory.files_, AddTrailingSlash(resourceDir) + directoryKey, "*.*", SCAN_FILES, false);
+
+    MutexLock lock(mutex_);
+    scannedDirectories_.Push(scannedDirectory);
+}
+
+//////////////////////////////////////////////////////////////////////////
+struct ResourceBrowser::ScanWorkItem : public WorkItem
+{
+    /// Scan task.
+    SharedPtr<ResourceScanTask> task_;
+    /// Resource directory to scan.
+    String resourceDir_;
+    /// Directory to scan.
+    String directoryKey_;
+    /// Index of resource directory.
+    unsigned resourceDirIndex_ = 0;
+};
+
+struct ResourceBrowser::RecognitionWorkItem : public WorkItem
+{
+    /// Scan task.
+    SharedPtr<ResourceScanTask> task_;
+    /// Files to recognize.
+    Vector<SharedPtr<ResourceFileDesc>> files_;
+    /// File names of files, empty if file is inaccessible. Written by worker thread.
+    Vector<String> fileNames_;
+    /// Type index entries of files. Written by worker thread.
+    Vector<ResourceTypeIndex::Entry> entries_;
+    /// Number of files missing in type index. Written by worker thread.
+    unsigned numMisses_ = 0;
+};
+
 ResourceBrowser::ResourceBrowser(AbstractMainWindow* mainWindow)
     : Object(mainWindow->GetContext())
     , fileSystem_(GetSubsystem<FileSystem>())
     , cache_(GetSubsystem<ResourceCache>())
+    , thumbnails_(MakeShared<ResourceThumbnailCache>(context_))
 {
     rootDirectory_.name_ = "Root";
 
@@ -160,12 +729,28 @@ ResourceBrowser::ResourceBrowser(AbstractMainWindow* mainWindow)
     dock_->SetName("Resource Browser");
 
     layout_ = dock_->CreateContent<AbstractLayout>();
-    directoriesView_ = layout_->CreateCell<AbstractHierarchyList>(0, 0);
+    searchEdit_ = layout_->CreateRow<AbstractLineEdit>(0);
+    searchEdit_->onTextEdited_ = [=]()
+    {
+        SetSearchQuery(searchEdit_->GetText());
+    };
+    directoriesView_ = layout_->CreateCell<AbstractHierarchyList>(1, 0);
     directoriesView_->onItemClicked_ = [=](AbstractHierarchyListItem* item)
     {
+        // Show directory content instead of search results
+        if (IsSearching())
+        {
+            searchEdit_->SetText(String::EMPTY);
+            searchQuery_.Clear();
+        }
         UpdateFileView(*static_cast<ResourceDirectoryItem*>(item)->GetDesc());
     };
-    filesView_ = layout_->CreateCell<AbstractHierarchyList>(0, 1);
+    filesView_ = layout_->CreateCell<AbstractHierarchyList>(1, 1);
+    filesView_->onMoreItemsRequested_ = [=]()
+    {
+        if (fileViewDirectory_ && !IsSearching())
+            AddFileViewItems(fileViewPageSize_);
+    };
     filesView_->onItemClicked_ = [=](AbstractHierarchyListItem* item)
     {
         if (onResourceClicked_)
@@ -176,6 +761,23 @@ ResourceBrowser::ResourceBrowser(AbstractMainWindow* mainWindow)
         if (onResourceDoubleClicked_)
             onResourceDoubleClicked_(*static_cast<ResourceFileItem*>(item)->GetDesc());
     };
+
+    thumbnails_->onThumbnailReady_ = [=](ResourceFileDesc& file)
+    {
+        if (file.item_)
+            filesView_->UpdateItem(file.item_);
+    };
+
+    SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(ResourceBrowser, HandleEndFrame));
+}
+
+ResourceBrowser::~ResourceBrowser()
+{
+    // Save types of changed files
+    if (!scanTask_ && typeIndex_ && typeIndexChanged_ && !typeIndexFileName_.Empty())
+        typeIndex_->Save(context_, typeIndexFileName_);
+
+    CancelScan();
 }
 
 void ResourceBrowser::AddXmlExtension(const String& extension)
@@ -196,38 +798,46 @@ void ResourceBrowser::AddLayers(const Vector<SharedPtr<ResourceRecognitionLayer>
 void ResourceBrowser::ScanResources()
 {
     // Remember selected directory
-    String selectedDirectory;
     if (const ResourceDirectoryDesc* directory = GetSelectedDirectory())
-        selectedDirectory = directory->directoryKey_;
+        pendingSelectedDirectory_ = directory->directoryKey_;
+
+    CancelScan();
 
     // Cleanup caches
+    directoriesView_->RemoveAllItems();
+    filesView_->RemoveAllItems();
+    fileViewDirectory_ = nullptr;
+    fileViewDirty_ = false;
+    numFileViewItems_ = 0;
+    searchIndex_.Clear();
+    dependencyIndex_.Clear();
     ClearDirectory(rootDirectory_);
     directories_.Clear();
     directories_[""] = &rootDirectory_;
-
-    // Scan resources
-    const Vector<String> resourceDirs = cache_->GetResourceDirs();
-    for (unsigned i = 0; i < resourceDirs.Size(); ++i)
-        ScanResourceDirectory(resourceDirs[i], i);
-
-    // Sort
-    SortChildrenDirectories(rootDirectory_);
-
-    // Update UI
-    directoriesView_->RemoveAllItems();
-    filesView_->RemoveAllItems();
     UpdateDirectoryView(rootDirectory_, 0, nullptr);
+    if (pendingSelectedDirectory_.Empty())
+        SelectDirectory(pendingSelectedDirectory_);
 
-    // Select directory
-    SelectDirectory(selectedDirectory);
-
-    // Update types
-    for (auto& item : directories_)
+    // Load type index if recognition layers are changed
+    recognizer_ = MakeShared<ResourceTypeRecognizer>(context_, recognitionLayers_, xmlExtensions_);
+    const unsigned signature = recognizer_->GetSignature();
+    if (!typeIndex_ || typeIndex_->GetSignature() != signature)
     {
-        ResourceDirectoryDesc& directory = *item.second_;
-        for (ResourceFileDesc* file : directory.files_)
-            file->type_ = GetResourceType(*file);
+        typeIndex_ = MakeShared<ResourceTypeIndex>(signature);
+        if (!typeIndexFileName_.Empty())
+            typeIndex_->Load(context_, typeIndexFileName_);
     }
+    nextTypeIndex_ = MakeShared<ResourceTypeIndex>(signature);
+    typeIndexChanged_ = false;
+
+    // Changes made during the scan are applied after it
+    resourceDirs_ = cache_->GetResourceDirs();
+    StartWatching();
+
+    // Scan resource directories in background
+    scanTask_ = MakeShared<ResourceScanTask>(fileSystem_, resourceDirs_, recognizer_, typeIndex_);
+    for (unsigned i = 0; i < resourceDirs_.Size(); ++i)
+        QueueDirectoryScan(scanTask_, i, String::EMPTY);
 }
 
 const ResourceDirectoryDesc* ResourceBrowser::GetSelectedDirectory() const
@@ -253,25 +863,62 @@ bool ResourceBrowser::SelectDirectory(const String& directoryKey)
     return true;
 }
 
-void ResourceBrowser::SortChildrenDirectories(ResourceDirectoryDesc& directory)
+void ResourceBrowser::SetSearchQuery(const String& query)
 {
-    // Sort directories
-    Sort(directory.children_.Begin(), directory.children_.End(),
-        [](ResourceDirectoryDesc* lhs, ResourceDirectoryDesc* rhs)
-    {
-        return lhs->name_ < rhs->name_;
-    });
+    const String trimmedQuery = query.Trimmed();
+    if (trimmedQuery == searchQuery_)
+        return;
 
-    // Sort files
-    Sort(directory.files_.Begin(), directory.files_.End(),
-        [](ResourceFileDesc* lhs, ResourceFileDesc* rhs)
+    searchQuery_ = trimmedQuery;
+    if (IsSearching())
+        UpdateSearchView();
+    else if (fileViewDirectory_)
+        UpdateFileView(*fileViewDirectory_);
+    else
+        filesView_->RemoveAllItems();
+}
+
+void ResourceBrowser::GetDependencies(const ResourceFileDesc& file, Vector<String>& result) const
+{
+    dependencyIndex_.GetDependencies(file.GetResourceName(), result);
+}
+
+void ResourceBrowser::GetUsages(const ResourceFileDesc& file, Vector<String>& result) const
+{
+    dependencyIndex_.GetUsages(file.GetResourceName(), result);
+}
+
+void ResourceBrowser::ScanResourceDirectoryWork(const WorkItem* item, unsigned /*threadIndex*/)
+{
+    const ScanWorkItem* scanItem = static_cast<const ScanWorkItem*>(item);
+    scanItem->task_->ScanResourceDirectory(scanItem->resourceDir_, scanItem->directoryKey_, scanItem->resourceDirIndex_);
+}
+
+void ResourceBrowser::RecognizeResourceTypesWork(const WorkItem* item, unsigned /*threadIndex*/)
+{
+    // Work item is not touched by main thread until completed
+    RecognitionWorkItem* recognitionItem = const_cast<RecognitionWorkItem*>(static_cast<const RecognitionWorkItem*>(item));
+    const ResourceScanTask& task = *recognitionItem->task_;
+    for (unsigned i = 0; i < recognitionItem->files_.Size(); ++i)
     {
-        return lhs->name_ < rhs->name_;
-    });
+        if (task.IsCancelled())
+            return;
+
+        // Look up previous scan results first
+        const ResourceFileDesc& file = *recognitionItem->files_[i];
+        String& fileName = recognitionItem->fileNames_[i];
+        ResourceTypeIndex::Entry& entry = recognitionItem->entries_[i];
+        fileName = task.GetFileName(file);
+        if (!GetFileStats(fileName, entry.size_, entry.modifiedTime_))
+            fileName.Clear();
+        else if (task.GetTypeIndex().FindEntry(fileName, entry.size_, entry.modifiedTime_, entry))
+            continue;
 
-    // Recurse
-    for (ResourceDirectoryDesc* child : directory.children_)
-        SortChildrenDirectories(*child);
+        const ResourceTypeRecognizer& recognizer = task.GetRecognizer();
+        entry.type_ = recognizer.GetResourceType(file.resourceKey_, file.extension_);
+        recognizer.GetDependencies(file.resourceKey_, file.extension_, entry.type_, entry.dependencies_);
+        ++recognitionItem->numMisses_;
+    }
 }
 
 void ResourceBrowser::ClearDirectory(ResourceDirectoryDesc& directory)
@@ -280,126 +927,404 @@ void ResourceBrowser::ClearDirectory(ResourceDirectoryDesc& directory)
     directory.files_.Clear();
 }
 
-ResourceType ResourceBrowser::GetResourceType(const ResourceFileDesc& desc)
+void ResourceBrowser::HandleEndFrame(StringHash /*eventType*/, VariantMap& /*eventData*/)
 {
-    SharedPtr<File> file;
-    String fileId;
-    String rootNode;
+    if (!scanTask_)
+        ApplyFileChanges();
+
+    if (ResourceScanTask* task = scanTask_ ? scanTask_ : changeTask_)
+        ApplyScanResults(task);
 
-    for (ResourceRecognitionLayer* layer : recognitionLayers_)
+    // Search results are updated at most once per frame
+    if (IsSearching())
     {
-        // Try to parse file name
-        if (layer->CanParseFileName())
-        {
-            const ResourceType typeByName = layer->ParseFileName(desc.extension_, desc.resourceKey_);
-            if (!typeByName.IsEmpty())
-                return typeByName;
-        }
+        if (searchViewDirty_ || searchRevision_ != searchIndex_.GetRevision())
+            UpdateSearchView();
+    }
+    else if (fileViewDirty_ && fileViewDirectory_)
+        UpdateFileView(*fileViewDirectory_);
 
-        // Load file if needed
-        if (layer->CanParseFileID() || layer->CanParseRootNode())
-        {
-            file = cache_->GetFile(desc.resourceKey_, false);
-        }
+    if (scanTask_ && scanItems_.Empty() && recognitionItems_.Empty() && nextScannedDirectory_ == scannedDirectories_.Size())
+        FinishScan();
+}
 
-        // Try to parse file ID
-        if (layer->CanParseFileID())
-        {
-            // Load file ID
-            if (fileId.Empty())
-            {
-                file->Seek(0);
-                fileId = file->ReadFileID();
-            }
+void ResourceBrowser::ApplyScanResults(ResourceScanTask* task)
+{
+    // Directories scanned by completed items are already taken below
+    for (unsigned i = 0; i < scanItems_.Size();)
+    {
+        if (scanItems_[i]->completed_)
+            scanItems_.Erase(i);
+        else
+            ++i;
+    }
 
-            const ResourceType typeById = layer->ParseFileID(fileId);
-            if (!typeById.IsEmpty())
-                return typeById;
-        }
+    if (nextScannedDirectory_ == scannedDirectories_.Size())
+    {
+        scannedDirectories_.Clear();
+        nextScannedDirectory_ = 0;
+    }
+    task->TakeScannedDirectories(scannedDirectories_);
 
-        // Try to parse root node name
-        if (layer->CanParseRootNode() && xmlExtensions_.Contains(desc.extension_))
+    // Keep UI responsive while applying results
+    HiresTimer timer;
+    const long long maxTime = static_cast<long long>(maxScanUpdateTime_ * 1000.0f);
+    while (nextScannedDirectory_ < scannedDirectories_.Size() && timer.GetUSec(false) < maxTime)
+        ApplyScannedDirectory(scannedDirectories_[nextScannedDirectory_++]);
+
+    ApplyRecognizedTypes();
+}
+
+void ResourceBrowser::FinishScan()
+{
+    // Removed files are dropped from the index too
+    if (nextTypeIndex_->GetNumEntries() != typeIndex_->GetNumEntries())
+        typeIndexChanged_ = true;
+
+    typeIndex_ = nextTypeIndex_;
+    if (typeIndexChanged_ && !typeIndexFileName_.Empty())
+        typeIndex_->Save(context_, typeIndexFileName_);
+    typeIndexChanged_ = false;
+
+    CancelScan();
+    pendingSelectedDirectory_.Clear();
+}
+
+void ResourceBrowser::CancelScan()
+{
+    if (scanTask_)
+        scanTask_->Cancel();
+    if (changeTask_)
+        changeTask_->Cancel();
+
+    // Work queue keeps items alive until they are completed
+    scanTask_.Reset();
+    changeTask_.Reset();
+    changedFiles_.Clear();
+    nextTypeIndex_.Reset();
+    scanItems_.Clear();
+    recognitionItems_.Clear();
+    scannedDirectories_.Clear();
+    nextScannedDirectory_ = 0;
+}
+
+void ResourceBrowser::ApplyScannedDirectory(const ScannedResourceDirectory& scannedDirectory)
+{
+    ResourceDirectoryDesc& directory = GetOrCreateDirectory(scannedDirectory.directoryKey_);
+    if (scannedDirectory.files_.Empty())
+        return;
+
+    // Files may be already added by file watcher
+    Vector<SharedPtr<ResourceFileDesc>> files;
+    for (const String& file : scannedDirectory.files_)
+    {
+        if (!FindFile(directory, file, scannedDirectory.resourceDirIndex_))
+            files.Push(CreateFileDesc(directory, file, scannedDirectory.resourceDirIndex_));
+    }
+    if (files.Empty())
+        return;
+
+    directory.files_.Push(files);
+    for (ResourceFileDesc* file : files)
+        searchIndex_.AddFile(file);
+    Sort(directory.files_.Begin(), directory.files_.End(),
+        [](ResourceFileDesc* lhs, ResourceFileDesc* rhs)
+    {
+        return lhs->name_ < rhs->name_;
+    });
+
+    if (&directory == fileViewDirectory_)
+        fileViewDirty_ = true;
+
+    QueueTypeRecognition(scanTask_ ? scanTask_ : changeTask_, files);
+}
+
+void ResourceBrowser::ApplyRecognizedTypes()
+{
+    // File changes are written to the index directly
+    ResourceTypeIndex* typeIndex = scanTask_ ? nextTypeIndex_ : typeIndex_;
+    for (unsigned i = 0; i < recognitionItems_.Size();)
+    {
+        RecognitionWorkItem* item = recognitionItems_[i];
+        if (!item->completed_)
         {
-            // Load root node name
-            if (rootNode.Empty())
-            {
-                file->Seek(0);
-                XMLFile xml(context_);
-                xml.Load(*file);
-                rootNode = xml.GetRoot().GetName();
-            }
+            ++i;
+            continue;
+        }
 
-            const ResourceType xmlType = layer->ParseRootNode(rootNode);
-            if (!xmlType.IsEmpty())
-                return xmlType;
+        for (unsigned j = 0; j < item->files_.Size(); ++j)
+        {
+            item->files_[j]->type_ = item->entries_[j].type_;
+            dependencyIndex_.SetDependencies(item->files_[j]->GetResourceName(), item->entries_[j].dependencies_);
+            if (typeIndex && !item->fileNames_[j].Empty())
+                typeIndex->SetEntry(item->fileNames_[j], item->entries_[j]);
         }
+        if (item->numMisses_ > 0)
+            typeIndexChanged_ = true;
+        // Search by type may match recognized files
+        searchViewDirty_ = true;
+        recognitionItems_.Erase(i);
     }
-    return ResourceType::EMPTY;
 }
 
-void ResourceBrowser::ScanResourceDirectory(const String& path, unsigned resourceDirIndex)
+void ResourceBrowser::QueueDirectoryScan(ResourceScanTask* task, unsigned resourceDirIndex, const String& directoryKey)
 {
-    Vector<String> directories;
-    fileSystem_->ScanDir(directories, path, "*.*", SCAN_DIRS, true);
-    for (const String& directory : directories)
+    auto item = MakeShared<ScanWorkItem>();
+    item->workFunction_ = ScanResourceDirectoryWork;
+    item->task_ = task;
+    item->resourceDir_ = resourceDirs_[resourceDirIndex];
+    item->directoryKey_ = directoryKey;
+    item->resourceDirIndex_ = resourceDirIndex;
+    GetSubsystem<WorkQueue>()->AddWorkItem(item);
+    scanItems_.Push(item);
+}
+
+void ResourceBrowser::QueueTypeRecognition(ResourceScanTask* task, const Vector<SharedPtr<ResourceFileDesc>>& files)
+{
+    WorkQueue* workQueue = GetSubsystem<WorkQueue>();
+    for (unsigned begin = 0; begin < files.Size(); begin += maxFilesPerRecognitionItem_)
     {
-        if (directory.EndsWith("."))
-            continue;
-        AddDirectory(directory, path, resourceDirIndex);
+        const unsigned end = Min(begin + maxFilesPerRecognitionItem_, files.Size());
+
+        auto item = MakeShared<RecognitionWorkItem>();
+        item->workFunction_ = RecognizeResourceTypesWork;
+        item->task_ = task;
+        for (unsigned i = begin; i < end; ++i)
+            item->files_.Push(files[i]);
+        item->fileNames_.Resize(item->files_.Size());
+        item->entries_.Resize(item->files_.Size());
+        workQueue->AddWorkItem(item);
+        recognitionItems_.Push(item);
     }
+}
 
-    ScanResourceFiles(rootDirectory_, path, resourceDirIndex);
+ResourceScanTask* ResourceBrowser::GetChangeTask()
+{
+    // Changed files are always recognized
+    if (!changeTask_)
+    {
+        auto emptyIndex = MakeShared<ResourceTypeIndex>(recognizer_->GetSignature());
+        changeTask_ = MakeShared<ResourceScanTask>(fileSystem_, resourceDirs_, recognizer_, emptyIndex);
+    }
+    return changeTask_;
 }
 
-void ResourceBrowser::AddDirectory(const String& directoryKey, const String& resourceDir, unsigned resourceDirIndex)
+void ResourceBrowser::StartWatching()
 {
-    if (directories_.Contains(directoryKey))
+    watchers_.Clear();
+    if (!fileWatching_)
         return;
 
-    const Vector<String> parts = directoryKey.Split('/');
+    for (const String& resourceDir : resourceDirs_)
+    {
+        auto watcher = MakeShared<FileWatcher>(context_);
+        watcher->StartWatching(resourceDir, true);
+        watchers_.Push(watcher);
+    }
+}
 
-    // Iterate from root to trunk
-    String parentKey;
-    ResourceDirectoryDesc* parent = &rootDirectory_;
-    for (unsigned i = 0; i < parts.Size(); ++i)
+void ResourceBrowser::ApplyFileChanges()
+{
+    for (unsigned i = 0; i < watchers_.Size(); ++i)
     {
-        // Make path
-        if (i > 0)
-            parentKey += "/";
-        parentKey += parts[i];
+        String fileKey;
+        while (watchers_[i]->GetNextChange(fileKey))
+            ApplyFileChange(i, GetInternalPath(fileKey));
+    }
 
-        // Create directory if missing
-        if (!directories_.Contains(parentKey))
+    if (!changedFiles_.Empty())
+    {
+        QueueTypeRecognition(GetChangeTask(), changedFiles_);
+        changedFiles_.Clear();
+    }
+}
+
+void ResourceBrowser::ApplyFileChange(unsigned resourceDirIndex, const String& fileKey)
+{
+    const String fileName = AddTrailingSlash(resourceDirs_[resourceDirIndex]) + fileKey;
+    const unsigned separator = fileKey.FindLast('/');
+    const bool hasParent = separator != String::NPOS;
+    const String directoryKey = hasParent ? fileKey.Substring(0, separator) : String::EMPTY;
+    const String name = hasParent ? fileKey.Substring(separator + 1) : fileKey;
+
+    if (fileSystem_->DirExists(fileName))
+    {
+        // Scan new directory in background and watch it
+        if (!directories_.Contains(fileKey))
         {
-            auto desc = MakeShared<ResourceDirectoryDesc>();
-            desc->directoryKey_ = parentKey;
-            desc->name_ = parts[i];
+            QueueDirectoryScan(GetChangeTask(), resourceDirIndex, fileKey);
+            watchers_[resourceDirIndex]->StartWatching(resourceDirs_[resourceDirIndex], true);
+        }
+    }
+    else if (fileSystem_->FileExists(fileName))
+    {
+        // Add new file, recognize type of new or modified file
+        ResourceDirectoryDesc& directory = GetOrCreateDirectory(directoryKey);
+        ResourceFileDesc* file = FindFile(directory, name, resourceDirIndex);
+        if (!file)
+            file = InsertFile(directory, name, resourceDirIndex);
+        changedFiles_.Push(SharedPtr<ResourceFileDesc>(file));
+
+        thumbnails_->InvalidateThumbnail(*file);
+        if (file->item_)
+            filesView_->UpdateItem(file->item_);
+    }
+    else if (directories_.Contains(fileKey))
+    {
+        // Keep directory present in another resource directory
+        for (unsigned i = 0; i < resourceDirs_.Size(); ++i)
+        {
+            if (i != resourceDirIndex && fileSystem_->DirExists(AddTrailingSlash(resourceDirs_[i]) + fileKey))
+                return;
+        }
+        EraseDirectory(*directories_[fileKey]);
+    }
+    else if (directories_.Contains(directoryKey))
+        EraseFile(*directories_[directoryKey], name, resourceDirIndex);
+}
+
+SharedPtr<ResourceFileDesc> ResourceBrowser::CreateFileDesc(const ResourceDirectoryDesc& directory, const String& name, unsigned resourceDirIndex) const
+{
+    auto fileDesc = MakeShared<ResourceFileDesc>();
+    fileDesc->name_ = name;
+    fileDesc->extension_ = GetExtension(name);
+    fileDesc->resourceKey_ = directory.directoryKey_ + "/" + name;
+    fileDesc->resourceDirIndex_ = resourceDirIndex;
+    return fileDesc;
+}
 
-            parent->children_.Push(desc);
-            directories_[parentKey] = desc;
+ResourceFileDesc* ResourceBrowser::FindFile(const ResourceDirectoryDesc& directory, const String& name, unsigned resourceDirIndex) const
+{
+    const Vector<SharedPtr<ResourceFileDesc>>& files = directory.files_;
+    for (unsigned i = FindFirstIndex(files, name); i < files.Size() && files[i]->name_ == name; ++i)
+    {
+        if (files[i]->resourceDirIndex_ == resourceDirIndex)
+            return files[i];
+    }
+    return nullptr;
+}
+
+ResourceFileDesc* ResourceBrowser::InsertFile(ResourceDirectoryDesc& directory, const String& name, unsigned resourceDirIndex)
+{
+    SharedPtr<ResourceFileDesc> file = CreateFileDesc(directory, name, resourceDirIndex);
+    const unsigned index = FindInsertionIndex(directory.files_, name);
+    directory.files_.Insert(index, file);
+    searchIndex_.AddFile(file);
+
+    if (&directory == fileViewDirectory_ && !fileViewDirty_ && !IsSearching())
+    {
+        // Files after the shown ones are added on demand
+        if (index <= numFileViewItems_)
+        {
+            filesView_->AddItem(CreateFileItem(file, false), index, nullptr);
+            ++numFileViewItems_;
         }
+        else
+            filesView_->SetHasMoreItems(true);
+    }
+    return file;
+}
+
+void ResourceBrowser::EraseFile(ResourceDirectoryDesc& directory, const String& name, unsigned resourceDirIndex)
+{
+    Vector<SharedPtr<ResourceFileDesc>>& files = directory.files_;
+    for (unsigned i = FindFirstIndex(files, name); i < files.Size() && files[i]->name_ == name; ++i)
+    {
+        if (files[i]->resourceDirIndex_ != resourceDirIndex)
+            continue;
 
-        // Get the parent
-        parent = directories_[parentKey];
+        // Item is alive only while it's shown either in directory content or in search results
+        if (files[i]->item_)
+        {
+            filesView_->RemoveItem(files[i]->item_);
+            if (&directory == fileViewDirectory_ && !IsSearching())
+                --numFileViewItems_;
+        }
+        searchIndex_.RemoveFile(files[i]);
+        dependencyIndex_.RemoveDependencies(files[i]->GetResourceName());
+        EraseTypeIndexEntry(*files[i]);
+        files.Erase(i);
+        return;
     }
+}
 
-    ScanResourceFiles(*parent, resourceDir, resourceDirIndex);
+void ResourceBrowser::EraseTypeIndexEntry(const ResourceFileDesc& file)
+{
+    // Index being built by scan may already contain the file
+    const String fileName = AddTrailingSlash(resourceDirs_[file.resourceDirIndex_]) + file.GetResourceName();
+    if (typeIndex_ && typeIndex_->RemoveEntry(fileName))
+        typeIndexChanged_ = true;
+    if (nextTypeIndex_ && nextTypeIndex_->RemoveEntry(fileName))
+        typeIndexChanged_ = true;
 }
 
-void ResourceBrowser::ScanResourceFiles(ResourceDirectoryDesc& directory, const String& resourceDir, unsigned resourceDirIndex)
+void ResourceBrowser::EraseDirectory(ResourceDirectoryDesc& directory)
 {
-    Vector<String> files;
-    fileSystem_->ScanDir(files, resourceDir + directory.directoryKey_, "*.*", SCAN_FILES, false);
+    SharedPtr<ResourceDirectoryDesc> holder(&directory);
+    ForgetDirectory(directory);
+
+    if (directory.item_)
+        directoriesView_->RemoveItem(directory.item_);
+
+    const unsigned separator = directory.directoryKey_.FindLast('/');
+    const String parentKey = separator != String::NPOS ? directory.directoryKey_.Substring(0, separator) : String::EMPTY;
+    if (directories_.Contains(parentKey))
+        directories_[parentKey]->children_.Remove(holder);
+}
+
+void ResourceBrowser::ForgetDirectory(ResourceDirectoryDesc& directory)
+{
+    directories_.Erase(directory.directoryKey_);
+    for (ResourceFileDesc* file : directory.files_)
+    {
+        if (file->item_)
+            filesView_->RemoveItem(file->item_);
+        searchIndex_.RemoveFile(file);
+        dependencyIndex_.RemoveDependencies(file->GetResourceName());
+        EraseTypeIndexEntry(*file);
+    }
 
-    for (const String& file : files)
+    if (&directory == fileViewDirectory_)
     {
-        auto fileDesc = MakeShared<ResourceFileDesc>();
-        fileDesc->name_ = file;
-        fileDesc->extension_ = GetExtension(file);
-        fileDesc->resourceKey_ = directory.directoryKey_ + "/" + file;
-        fileDesc->resourceDirIndex_ = resourceDirIndex;
-        directory.files_.Push(fileDesc);
+        if (!IsSearching())
+            filesView_->RemoveAllItems();
+        fileViewDirectory_ = nullptr;
+        fileViewDirty_ = false;
+        numFileViewItems_ = 0;
     }
+
+    for (ResourceDirectoryDesc* child : directory.children_)
+        ForgetDirectory(*child);
+}
+
+ResourceDirectoryDesc& ResourceBrowser::GetOrCreateDirectory(const String& directoryKey)
+{
+    auto iter = directories_.Find(directoryKey);
+    if (iter != directories_.End())
+        return *iter->second_;
+
+    // Create parent first
+    const unsigned separator = directoryKey.FindLast('/');
+    const bool hasParent = separator != String::NPOS;
+    ResourceDirectoryDesc& parent = GetOrCreateDirectory(hasParent ? directoryKey.Substring(0, separator) : String::EMPTY);
+
+    auto desc = MakeShared<ResourceDirectoryDesc>();
+    desc->directoryKey_ = directoryKey;
+    desc->name_ = hasParent ? directoryKey.Substring(separator + 1) : directoryKey;
+
+    const unsigned index = FindInsertionIndex(parent.children_, desc->name_);
+    parent.children_.Insert(index, desc);
+    directories_[directoryKey] = desc;
+    UpdateDirectoryView(*desc, index, parent.item_);
+
+    // Restore selection
+    if (directoryKey == pendingSelectedDirectory_)
+    {
+        pendingSelectedDirectory_.Clear();
+        SelectDirectory(directoryKey);
+    }
+
+    return *desc;
 }
 
 void ResourceBrowser::UpdateDirectoryView(ResourceDirectoryDesc& directory, unsigned index, ResourceDirectoryItem* parent)
@@ -410,14 +1335,56 @@ void ResourceBrowser::UpdateDirectoryView(ResourceDirectoryDesc& directory, unsi
         UpdateDirectoryView(*directory.children_[i], i, directoryItem);
 }
 
+SharedPtr<ResourceFileItem> ResourceBrowser::CreateFileItem(ResourceFileDesc* file, bool showResourceKey)
+{
+    auto fileItem = MakeShared<ResourceFileItem>(context_, file, showResourceKey);
+    fileItem->SetThumbnailCache(thumbnails_);
+    return fileItem;
+}
+
 void ResourceBrowser::UpdateFileView(ResourceDirectoryDesc& directory)
 {
+    // Keep as many files shown as before if directory is the same
+    const unsigned numItems = &directory == fileViewDirectory_
+        ? Max(numFileViewItems_, fileViewPageSize_) : fileViewPageSize_;
+    fileViewDirectory_ = &directory;
+    fileViewDirty_ = false;
+
+    // Search results are shown instead
+    if (IsSearching())
+        return;
+
+    filesView_->RemoveAllItems();
+    numFileViewItems_ = 0;
+    AddFileViewItems(numItems);
+}
+
+void ResourceBrowser::AddFileViewItems(unsigned numItems)
+{
+    // Items are created only for files that are about to be shown
+    const Vector<SharedPtr<ResourceFileDesc>>& files = fileViewDirectory_->files_;
+    const unsigned end = Min(numFileViewItems_ + numItems, files.Size());
+    for (unsigned i = numFileViewItems_; i < end; ++i)
+    {
+        filesView_->AddItem(CreateFileItem(files[i], false), i, nullptr);
+    }
+    numFileViewItems_ = end;
+    filesView_->SetHasMoreItems(numFileViewItems_ < files.Size());
+}
+
+void ResourceBrowser::UpdateSearchView()
+{
+    searchRevision_ = searchIndex_.GetRevision();
+    searchViewDirty_ = false;
+
+    PODVector<ResourceFileDesc*> files;
+    searchIndex_.Search(searchQuery_, maxSearchResults_, files);
+
     filesView_->RemoveAllItems();
-    for (unsigned i = 0; i < directory.files_.Size(); ++i)
+    for (unsigned i = 0; i < files.Size(); ++i)
     {
-        auto fileItem = MakeShared<ResourceFileItem>(context_, directory.files_[i]);
-        filesView_->AddItem(fileItem, i, nullptr);
+        filesView_->AddItem(CreateFileItem(files[i], true), i, nullptr);
     }
 }
 
-}
\ No newline at end of file
+}
@@ -1,11 +1,17 @@
 #pragma once
 
 #include "../AbstractUI/AbstractUI.h"
+#include "ResourceDependencyIndex.h"
+#include "ResourceSearchIndex.h"
+#include "ResourceThumbnailCache.h"
+#include <Urho3D/Core/Mutex.h>
 
 namespace Urho3D
 {
 
 class FileSystem;
+class FileWatcher;
+struct WorkItem;
 
 class ResourceFileDesc;
 class ResourceDirectoryDesc;
@@ -13,14 +19,21 @@ class ResourceDirectoryDesc;
 class ResourceFileItem : public AbstractHierarchyListItem
 {
 public:
-    ResourceFileItem(Context* context, ResourceFileDesc* directory);
+    ResourceFileItem(Context* context, ResourceFileDesc* directory, bool showResourceKey = false);
     ResourceFileDesc* GetDesc() const { return file_; }
+    /// Set cache of shown thumbnails.
+    void SetThumbnailCache(ResourceThumbnailCache* thumbnails) { thumbnails_ = thumbnails; }
 
     String GetText() override;
+    Image* GetImage() override;
 
 private:
 
     ResourceFileDesc* file_ = nullptr;
+    /// Whether to show resource key instead of file name.
+    bool showResourceKey_ = false;
+    /// Cache of shown thumbnails.
+    WeakPtr<ResourceThumbnailCache> thumbnails_;
 };
 
 class ResourceDirectoryItem : public AbstractHierarchyListItem
@@ -46,6 +59,8 @@ struct ResourceType
     bool operator == (const ResourceType& rhs) const;
     bool operator != (const ResourceType& rhs) const { return !(*this == rhs); }
 
+    unsigned ToHash() const { return objectType_.Value() ^ StringHash(resourceType_).Value(); }
+
     StringHash objectType_;
     String resourceType_;
 };
@@ -53,6 +68,9 @@ struct ResourceType
 class ResourceFileDesc : public RefCounted
 {
 public:
+    /// Return resource name, i.e. resource key without leading slash.
+    String GetResourceName() const { return resourceKey_.StartsWith("/") ? resourceKey_.Substring(1) : resourceKey_; }
+
     String resourceKey_;
     unsigned resourceDirIndex_ = 0;
     String name_;
@@ -81,6 +99,8 @@ public:
     virtual ResourceType ParseFileID(const String& fileId);
     virtual bool CanParseRootNode() const { return false; }
     virtual ResourceType ParseRootNode(const String& rootName);
+    /// Return hash of layer configuration. Persistent type index is discarded when it's changed.
+    virtual unsigned ToHash() const { return 0; }
 };
 
 /// Shared pointer onto resource type recognition layer.
@@ -96,6 +116,7 @@ public:
 
     virtual bool CanParseFileName() const { return true; }
     ResourceType ParseFileName(const String& extension, const String& fullName) override;
+    unsigned ToHash() const override;
 
 private:
     const String extension_;
@@ -109,6 +130,7 @@ public:
 
     bool CanParseFileID() const override { return true; }
     ResourceType ParseFileID(const String& fileId) override;
+    unsigned ToHash() const override;
 
 private:
     const String fileId_;
@@ -122,6 +144,7 @@ public:
 
     bool CanParseRootNode() const override { return true; }
     ResourceType ParseRootNode(const String& rootName) override;
+    unsigned ToHash() const override;
 
 private:
     const String rootName_;
@@ -153,6 +176,120 @@ template <class T> ResourceRecognitionLayerSPtr MakeXmlLayer(const String& rootN
 /// Create XML type recognition layer for object type.
 template <class T> ResourceRecognitionLayerArray MakeXmlLayers(const Vector<String>& rootNames) { return MakeXmlLayers(rootNames, T::GetTypeNameStatic(), T::GetTypeStatic()); }
 
+/// Resource type recognizer. Immutable and safe to use from worker threads.
+class ResourceTypeRecognizer : public RefCounted
+{
+public:
+    /// Construct.
+    ResourceTypeRecognizer(Context* context, const ResourceRecognitionLayerArray& layers, const HashSet<String>& xmlExtensions);
+    /// Get resource file type.
+    ResourceType GetResourceType(const String& resourceKey, const String& extension) const;
+    /// Get names of resources referenced by resource file.
+    void GetDependencies(const String& resourceKey, const String& extension, const ResourceType& type, Vector<String>& dependencies) const;
+    /// Return signature of recognition layers.
+    unsigned GetSignature() const { return signature_; }
+
+private:
+    Context* context_ = nullptr;
+    ResourceCache* cache_ = nullptr;
+    const ResourceRecognitionLayerArray layers_;
+    const HashSet<String> xmlExtensions_;
+    unsigned signature_ = 0;
+};
+
+/// Persistent index of recognized resource types. Entry is valid while file size and modification time are unchanged.
+class ResourceTypeIndex : public RefCounted
+{
+public:
+    /// Index entry.
+    struct Entry
+    {
+        /// File size.
+        unsigned size_ = 0;
+        /// File modification time.
+        unsigned modifiedTime_ = 0;
+        /// Recognized type.
+        ResourceType type_;
+        /// Names of referenced resources.
+        Vector<String> dependencies_;
+    };
+
+    /// Construct.
+    explicit ResourceTypeIndex(unsigned signature) : signature_(signature) { }
+    /// Load index from file. Return false if file is missing, corrupted or has another signature.
+    bool Load(Context* context, const String& fileName);
+    /// Save index to file.
+    bool Save(Context* context, const String& fileName) const;
+    /// Add or replace entry.
+    void SetEntry(const String& fileName, const Entry& entry) { entries_[fileName] = entry; }
+    /// Remove entry. Return false if there's no entry.
+    bool RemoveEntry(const String& fileName) { return entries_.Erase(fileName); }
+    /// Find entry of file. Return false if there's no valid entry.
+    bool FindEntry(const String& fileName, unsigned size, unsigned modifiedTime, Entry& entry) const;
+
+    /// Return signature of recognition layers.
+    unsigned GetSignature() const { return signature_; }
+    /// Return number of entries.
+    unsigned GetNumEntries() const { return entries_.Size(); }
+
+private:
+    /// Signature of recognition layers.
+    const unsigned signature_;
+    /// Entries by file name.
+    HashMap<String, Entry> entries_;
+};
+
+/// Scanned resource directory.
+struct ScannedResourceDirectory
+{
+    /// Directory key.
+    String directoryKey_;
+    /// Index of resource directory.
+    unsigned resourceDirIndex_ = 0;
+    /// File names.
+    Vector<String> files_;
+};
+
+/// State of background resource scan shared with worker threads.
+class ResourceScanTask : public RefCounted
+{
+public:
+    /// Construct.
+    ResourceScanTask(FileSystem* fileSystem, const Vector<String>& resourceDirs,
+        SharedPtr<ResourceTypeRecognizer> recognizer, SharedPtr<ResourceTypeIndex> typeIndex)
+        : fileSystem_(fileSystem), resourceDirs_(resourceDirs), recognizer_(recognizer), typeIndex_(typeIndex) { }
+    /// Scan directory of resource directory recursively. Called from worker thread.
+    void ScanResourceDirectory(const String& resourceDir, const String& directoryKey, unsigned resourceDirIndex);
+    /// Take scanned directories. Called from main thread.
+    void TakeScannedDirectories(Vector<ScannedResourceDirectory>& directories);
+    /// Cancel the scan.
+    void Cancel() { cancelled_ = true; }
+    /// Return whether the scan is cancelled.
+    bool IsCancelled() const { return cancelled_; }
+    /// Return type recognizer.
+    const ResourceTypeRecognizer& GetRecognizer() const { return *recognizer_; }
+    /// Return type index of previous scan.
+    const ResourceTypeIndex& GetTypeIndex() const { return *typeIndex_; }
+    /// Return file name of resource file.
+    String GetFileName(const ResourceFileDesc& file) const;
+
+private:
+    /// Add scanned directory.
+    void AddScannedDirectory(const String& resourceDir, const String& directoryKey, unsigned resourceDirIndex);
+
+private:
+    FileSystem* fileSystem_ = nullptr;
+    const Vector<String> resourceDirs_;
+    const SharedPtr<ResourceTypeRecognizer> recognizer_;
+    const SharedPtr<ResourceTypeIndex> typeIndex_;
+    volatile bool cancelled_ = false;
+
+    /// Mutex for scanned directories.
+    Mutex mutex_;
+    /// Scanned directories not yet taken by main thread.
+    Vector<ScannedResourceDirectory> scannedDirectories_;
+};
+
 /// Resource Browser dock.
 class ResourceBrowser : public Object
 {
@@ -161,20 +298,44 @@ class ResourceBrowser : public Object
 public:
     /// Construct.
     ResourceBrowser(AbstractMainWindow* mainWindow);
+    /// Destruct.
+    ~ResourceBrowser() override;
 
-    /// Add XML extension filter.
+    /// Add XML extension filter. Takes effect on next scan.
     void AddXmlExtension(const String& extension);
-    /// Add resource type recognition layer.
+    /// Add resource type recognition layer. Takes effect on next scan.
     void AddLayer(const SharedPtr<ResourceRecognitionLayer>& layer);
-    /// Add multiple resource type recognition layers.
+    /// Add multiple resource type recognition layers. Takes effect on next scan.
     void AddLayers(const Vector<SharedPtr<ResourceRecognitionLayer>>& layers);
-    /// Rescan resources.
+    /// Rescan resources in background. Results are added to the browser as soon as they are ready.
     void ScanResources();
+    /// Set whether to watch resource directories and apply file changes incrementally. Takes effect on next scan.
+    void SetFileWatching(bool fileWatching) { fileWatching_ = fileWatching; }
+    /// Set file name of persistent type index. Types of unchanged files are loaded from the index instead of recognition.
+    void SetTypeIndexFileName(const String& fileName) { typeIndexFileName_ = fileName; }
+    /// Set maximum time in milliseconds spent on applying scan results per frame.
+    void SetMaxScanUpdateTime(float maxTime) { maxScanUpdateTime_ = maxTime; }
+    /// Return whether the scan is in progress.
+    bool IsScanning() const { return scanTask_ != nullptr; }
+    /// Return cache of file thumbnails.
+    ResourceThumbnailCache* GetThumbnailCache() const { return thumbnails_; }
+    /// Return names of resources referenced by file. Valid for files whose type is recognized.
+    void GetDependencies(const ResourceFileDesc& file, Vector<String>& result) const;
+    /// Return names of resources that reference file. Complete when the scan is finished.
+    void GetUsages(const ResourceFileDesc& file, Vector<String>& result) const;
 
     /// Return selected directory.
     const ResourceDirectoryDesc* GetSelectedDirectory() const;
     /// Set selected directory.
     bool SelectDirectory(const String& directoryKey);
+    /// Set search query. Matching files of all directories are shown instead of selected directory unless query is empty.
+    void SetSearchQuery(const String& query);
+    /// Set number of files added to file viewer at once.
+    void SetFileViewPageSize(unsigned pageSize) { fileViewPageSize_ = Max(1u, pageSize); }
+    /// Set maximum number of shown search results.
+    void SetMaxSearchResults(unsigned maxResults) { maxSearchResults_ = maxResults; }
+    /// Return whether the search results are shown.
+    bool IsSearching() const { return !searchQuery_.Empty(); }
 
 public:
     /// Called when file is clicked.
@@ -183,24 +344,70 @@ public:
     std::function<void(const ResourceFileDesc& file)> onResourceDoubleClicked_;
 
 private:
-    /// Recursive sort of directory content.
-    static void SortChildrenDirectories(ResourceDirectoryDesc& directory);
+    /// Work item that scans resource directory.
+    struct ScanWorkItem;
+    /// Work item that recognizes types of files.
+    struct RecognitionWorkItem;
+
+    /// Scan resource directory. Called from worker thread.
+    static void ScanResourceDirectoryWork(const WorkItem* item, unsigned threadIndex);
+    /// Recognize types of files. Called from worker thread.
+    static void RecognizeResourceTypesWork(const WorkItem* item, unsigned threadIndex);
+
     /// Clean directory content.
     static void ClearDirectory(ResourceDirectoryDesc& directory);
 
-    /// Get resource file type.
-    ResourceType GetResourceType(const ResourceFileDesc& desc);
-
-    /// Scan resource directory for directories and files.
-    void ScanResourceDirectory(const String& path, unsigned resourceDirIndex);
-    /// Add new directory with files.
-    void AddDirectory(const String& directoryKey, const String& resourceDir, unsigned resourceDirIndex);
-    /// Scan directory for files.
-    void ScanResourceFiles(ResourceDirectoryDesc& directory, const String& resourceDir, unsigned resourceDirIndex);
+    /// Handle end of frame.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+    /// Apply results of scan or file changes processing.
+    void ApplyScanResults(ResourceScanTask* task);
+    /// Cancel the scan in progress.
+    void CancelScan();
+    /// Add scanned directory and queue type recognition for its files.
+    void ApplyScannedDirectory(const ScannedResourceDirectory& scannedDirectory);
+    /// Apply recognized types of completed work items.
+    void ApplyRecognizedTypes();
+    /// Finish the scan and save type index.
+    void FinishScan();
+    /// Queue recursive scan of directory.
+    void QueueDirectoryScan(ResourceScanTask* task, unsigned resourceDirIndex, const String& directoryKey);
+    /// Queue type recognition of files.
+    void QueueTypeRecognition(ResourceScanTask* task, const Vector<SharedPtr<ResourceFileDesc>>& files);
+    /// Return task for processing of file changes.
+    ResourceScanTask* GetChangeTask();
+    /// Start watching resource directories.
+    void StartWatching();
+    /// Apply file changes reported by watchers.
+    void ApplyFileChanges();
+    /// Apply change of file or directory.
+    void ApplyFileChange(unsigned resourceDirIndex, const String& fileKey);
+    /// Create file description.
+    SharedPtr<ResourceFileDesc> CreateFileDesc(const ResourceDirectoryDesc& directory, const String& name, unsigned resourceDirIndex) const;
+    /// Find file in directory. Return null if not found.
+    ResourceFileDesc* FindFile(const ResourceDirectoryDesc& directory, const String& name, unsigned resourceDirIndex) const;
+    /// Add file to directory.
+    ResourceFileDesc* InsertFile(ResourceDirectoryDesc& directory, const String& name, unsigned resourceDirIndex);
+    /// Remove file from directory.
+    void EraseFile(ResourceDirectoryDesc& directory, const String& name, unsigned resourceDirIndex);
+    /// Remove type index entry of erased file.
+    void EraseTypeIndexEntry(const ResourceFileDesc& file);
+    /// Remove directory with content.
+    void EraseDirectory(ResourceDirectoryDesc& directory);
+    /// Forget directory and its children.
+    void ForgetDirectory(ResourceDirectoryDesc& directory);
+    /// Get directory, create it and its parents if missing.
+    ResourceDirectoryDesc& GetOrCreateDirectory(const String& directoryKey);
+
     /// Update directory viewer UI.
     void UpdateDirectoryView(ResourceDirectoryDesc& directory, unsigned index, ResourceDirectoryItem* parent);
+    /// Create file viewer item.
+    SharedPtr<ResourceFileItem> CreateFileItem(ResourceFileDesc* file, bool showResourceKey);
     /// Update file viewer UI.
     void UpdateFileView(ResourceDirectoryDesc& directory);
+    /// Add items for next files of directory shown in file viewer.
+    void AddFileViewItems(unsigned numItems);
+    /// Update file viewer UI with search results.
+    void UpdateSearchView();
 
 private:
     FileSystem* fileSystem_ = nullptr;
@@ -210,11 +417,75 @@ private:
 
     AbstractDock* dock_ = nullptr;
     AbstractLayout* layout_ = nullptr;
+    AbstractLineEdit* searchEdit_ = nullptr;
     AbstractHierarchyList* directoriesView_ = nullptr;
     AbstractHierarchyList* filesView_ = nullptr;
 
     ResourceDirectoryDesc rootDirectory_;
     HashMap<String, ResourceDirectoryDesc*> directories_;
+    /// Directory shown in file viewer.
+    ResourceDirectoryDesc* fileViewDirectory_ = nullptr;
+    /// Whether the file viewer shall be updated.
+    bool fileViewDirty_ = false;
+    /// Number of files added to file viewer at once.
+    unsigned fileViewPageSize_ = 256;
+    /// Number of leading files of directory that have items in file viewer.
+    unsigned numFileViewItems_ = 0;
+
+    /// Cache of file thumbnails.
+    SharedPtr<ResourceThumbnailCache> thumbnails_;
+
+    /// References between resources.
+    ResourceDependencyIndex dependencyIndex_;
+
+    /// Search index of all files.
+    ResourceSearchIndex searchIndex_;
+    /// Current search query.
+    String searchQuery_;
+    /// Revision of search index shown in file viewer.
+    unsigned searchRevision_ = 0;
+    /// Whether the search results shall be updated regardless of index revision.
+    bool searchViewDirty_ = false;
+    /// Maximum number of shown search results.
+    unsigned maxSearchResults_ = 500;
+
+    /// Maximum time in milliseconds spent on applying scan results per frame.
+    float maxScanUpdateTime_ = 5.0f;
+    /// Maximum number of files recognized by one work item.
+    unsigned maxFilesPerRecognitionItem_ = 256;
+    /// Resource directories of current scan.
+    Vector<String> resourceDirs_;
+    /// Type recognizer of current scan.
+    SharedPtr<ResourceTypeRecognizer> recognizer_;
+    /// Whether to watch resource directories.
+    bool fileWatching_ = true;
+    /// Watchers of resource directories.
+    Vector<SharedPtr<FileWatcher>> watchers_;
+    /// Task for processing of file changes.
+    SharedPtr<ResourceScanTask> changeTask_;
+    /// Changed files to recognize.
+    Vector<SharedPtr<ResourceFileDesc>> changedFiles_;
+
+    /// File name of persistent type index.
+    String typeIndexFileName_;
+    /// Type index of the last complete scan.
+    SharedPtr<ResourceTypeIndex> typeIndex_;
+    /// Type index filled by current scan.
+    SharedPtr<ResourceTypeIndex> nextTypeIndex_;
+    /// Whether the type index is changed by current scan.
+    bool typeIndexChanged_ = false;
+    /// Current scan.
+    SharedPtr<ResourceScanTask> scanTask_;
+    /// Scan work items in progress.
+    Vector<SharedPtr<ScanWorkItem>> scanItems_;
+    /// Recognition work items in progress.
+    Vector<SharedPtr<RecognitionWorkItem>> recognitionItems_;
+    /// Scanned directories not yet applied.
+    Vector<ScannedResourceDirectory> scannedDirectories_;
+    /// Index of the first scanned directory not yet applied.
+    unsigned nextScannedDirectory_ = 0;
+    /// Directory to select when it's scanned.
+    String pendingSelectedDirectory_;
 };
 
 }
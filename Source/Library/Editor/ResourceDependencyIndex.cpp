@@ -0,0 +1,132 @@
+#include "ResourceDependencyIndex.h"
+
+namespace Urho3D
+{
+
+namespace
+{
+
+/// Return index of the first value that is not less than given one.
+unsigned FindFirstIndex(const PODVector<unsigned>& values, unsigned value)
+{
+    unsigned first = 0;
+    unsigned last = values.Size();
+    while (first < last)
+    {
+        const unsigned middle = (first + last) / 2;
+        if (values[middle] < value)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    return first;
+}
+
+/// Insert value into sorted vector if missing.
+void InsertSorted(PODVector<unsigned>& values, unsigned value)
+{
+    const unsigned index = FindFirstIndex(values, value);
+    if (index == values.Size() || values[index] != value)
+        values.Insert(index, value);
+}
+
+/// Remove value from sorted vector.
+void EraseSorted(PODVector<unsigned>& values, unsigned value)
+{
+    const unsigned index = FindFirstIndex(values, value);
+    if (index < values.Size() && values[index] == value)
+        values.Erase(index);
+}
+
+}
+
+ResourceDependencyIndex::ResourceDependencyIndex() = default;
+
+ResourceDependencyIndex::~ResourceDependencyIndex() = default;
+
+void ResourceDependencyIndex::Clear()
+{
+    ids_.Clear();
+    names_.Clear();
+    dependencies_.Clear();
+    usages_.Clear();
+}
+
+void ResourceDependencyIndex::SetDependencies(const String& resourceName, const Vector<String>& dependencies)
+{
+    const unsigned id = FindId(resourceName);
+    if (id == M_MAX_UNSIGNED && dependencies.Empty())
+        return;
+
+    // Resource name spelling is taken from the resource itself
+    const unsigned sourceId = id != M_MAX_UNSIGNED ? id : GetOrAddId(resourceName);
+    names_[sourceId] = GetNormalizedName(resourceName);
+
+    PODVector<unsigned> newDependencies;
+    for (const String& dependency : dependencies)
+    {
+        const unsigned dependencyId = GetOrAddId(dependency);
+        if (dependencyId != sourceId)
+            InsertSorted(newDependencies, dependencyId);
+    }
+
+    for (unsigned dependencyId : dependencies_[sourceId])
+        EraseSorted(usages_[dependencyId], sourceId);
+    for (unsigned dependencyId : newDependencies)
+        InsertSorted(usages_[dependencyId], sourceId);
+    dependencies_[sourceId] = newDependencies;
+}
+
+void ResourceDependencyIndex::GetDependencies(const String& resourceName, Vector<String>& result) const
+{
+    const unsigned id = FindId(resourceName);
+    if (id != M_MAX_UNSIGNED)
+        GetNames(dependencies_[id], result);
+}
+
+void ResourceDependencyIndex::GetUsages(const String& resourceName, Vector<String>& result) const
+{
+    const unsigned id = FindId(resourceName);
+    if (id != M_MAX_UNSIGNED)
+        GetNames(usages_[id], result);
+}
+
+String ResourceDependencyIndex::GetNormalizedName(const String& resourceName)
+{
+    String name = resourceName.Trimmed().Replaced('\\', '/');
+    while (name.StartsWith("./"))
+        name = name.Substring(2);
+    while (name.StartsWith("/"))
+        name = name.Substring(1);
+    return name;
+}
+
+unsigned ResourceDependencyIndex::GetOrAddId(const String& resourceName)
+{
+    const String name = GetNormalizedName(resourceName);
+    const String key = name.ToLower();
+    auto iter = ids_.Find(key);
+    if (iter != ids_.End())
+        return iter->second_;
+
+    const unsigned id = names_.Size();
+    ids_[key] = id;
+    names_.Push(name);
+    dependencies_.Resize(names_.Size());
+    usages_.Resize(names_.Size());
+    return id;
+}
+
+unsigned ResourceDependencyIndex::FindId(const String& resourceName) const
+{
+    auto iter = ids_.Find(GetNormalizedName(resourceName).ToLower());
+    return iter != ids_.End() ? iter->second_ : M_MAX_UNSIGNED;
+}
+
+void ResourceDependencyIndex::GetNames(const PODVector<unsigned>& ids, Vector<String>& result) const
+{
+    for (unsigned id : ids)
+        result.Push(names_[id]);
+}
+
+}
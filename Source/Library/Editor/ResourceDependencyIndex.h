@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Container/Str.h>
+
+namespace Urho3D
+{
+
+/// Index of references between resources. Resources are identified by names, case-insensitively.
+class ResourceDependencyIndex
+{
+public:
+    /// Construct.
+    ResourceDependencyIndex();
+    /// Destruct.
+    ~ResourceDependencyIndex();
+
+    /// Remove all resources.
+    void Clear();
+    /// Set resources referenced by resource, replacing previous ones.
+    void SetDependencies(const String& resourceName, const Vector<String>& dependencies);
+    /// Remove references of resource. References to the resource are kept.
+    void RemoveDependencies(const String& resourceName) { SetDependencies(resourceName, Vector<String>()); }
+    /// Return names of resources referenced by resource.
+    void GetDependencies(const String& resourceName, Vector<String>& result) const;
+    /// Return names of resources that reference resource.
+    void GetUsages(const String& resourceName, Vector<String>& result) const;
+
+    /// Return normalized resource name.
+    static String GetNormalizedName(const String& resourceName);
+
+private:
+    /// Return identifier of resource, add resource if missing.
+    unsigned GetOrAddId(const String& resourceName);
+    /// Return identifier of resource or M_MAX_UNSIGNED if missing.
+    unsigned FindId(const String& resourceName) const;
+    /// Return names of resources.
+    void GetNames(const PODVector<unsigned>& ids, Vector<String>& result) const;
+
+private:
+    /// Identifiers by lower case resource names.
+    HashMap<String, unsigned> ids_;
+    /// Resource names by identifiers.
+    Vector<String> names_;
+    /// Sorted identifiers of referenced resources by identifier.
+    Vector<PODVector<unsigned>> dependencies_;
+    /// Sorted identifiers of referencing resources by identifier.
+    Vector<PODVector<unsigned>> usages_;
+};
+
+}
@@ -0,0 +1,279 @@
+#include "ResourceSearchIndex.h"
+#include "ResourceBrowser.h"
+#include <Urho3D/Container/Sort.h>
+
+namespace Urho3D
+{
+
+namespace
+{
+
+/// Character that pads beginning of name, so that prefixes are indexed as trigrams.
+const char PREFIX_PAD = '\x01';
+
+/// Minimum number of removed entries that triggers compaction.
+const unsigned MIN_REMOVED_TO_COMPACT = 1024;
+
+/// Search match.
+struct SearchMatch
+{
+    /// Compare matches, better first.
+    bool operator <(const SearchMatch& rhs) const
+    {
+        if (rank_ != rhs.rank_)
+            return rank_ < rhs.rank_;
+        if (name_->Length() != rhs.name_->Length())
+            return name_->Length() < rhs.name_->Length();
+        return *name_ < *rhs.name_;
+    }
+
+    /// Rank of match, lower is better.
+    unsigned rank_;
+    /// Lower case file name.
+    const String* name_;
+    /// File.
+    ResourceFileDesc* file_;
+};
+
+/// Return whether the character separates words.
+bool IsWordSeparator(char ch)
+{
+    return !IsAlpha(static_cast<unsigned char>(ch)) && !IsDigit(static_cast<unsigned char>(ch));
+}
+
+/// Return whether the word is matched by the resource key. Short words match beginning of name only.
+bool IsWordMatched(const String& key, const String& name, const String& word)
+{
+    return word.Length() < 3 ? name.StartsWith(word) : key.Contains(word);
+}
+
+/// Return rank of word match, lower is better. Matches in name are preferred to matches in directory.
+unsigned GetMatchRank(const String& name, const String& word)
+{
+    const unsigned position = name.Find(word);
+    if (position == 0)
+    {
+        // Whole name or name without extension
+        if (name.Length() == word.Length() || name[word.Length()] == '.')
+            return 0;
+        return 1;
+    }
+    if (position == String::NPOS)
+        return 4;
+    if (IsWordSeparator(name[position - 1]))
+        return 2;
+    return 3;
+}
+
+/// Intersect sorted vectors in place.
+void IntersectSorted(PODVector<unsigned>& result, const PODVector<unsigned>& other)
+{
+    unsigned numResults = 0;
+    unsigned j = 0;
+    for (unsigned i = 0; i < result.Size() && j < other.Size(); ++i)
+    {
+        while (j < other.Size() && other[j] < result[i])
+            ++j;
+        if (j < other.Size() && other[j] == result[i])
+            result[numResults++] = result[i];
+    }
+    result.Resize(numResults);
+}
+
+}
+
+ResourceSearchIndex::ResourceSearchIndex() = default;
+
+ResourceSearchIndex::~ResourceSearchIndex() = default;
+
+void ResourceSearchIndex::Clear()
+{
+    entries_.Clear();
+    slots_.Clear();
+    postings_.Clear();
+    numRemoved_ = 0;
+    ++revision_;
+}
+
+void ResourceSearchIndex::AddFile(ResourceFileDesc* file)
+{
+    if (!file || slots_.Contains(file))
+        return;
+
+    const unsigned index = entries_.Size();
+    Entry entry;
+    entry.file_ = file;
+    entry.key_ = file->GetResourceName().ToLower();
+    entry.name_ = file->name_.ToLower();
+    entries_.Push(entry);
+    slots_[file] = index;
+
+    // Entries are appended, so posting lists stay sorted and duplicates are adjacent
+    auto addPosting = [&](char first, char second, char third)
+    {
+        PODVector<unsigned>& postings = postings_[GetKey(first, second, third)];
+        if (postings.Empty() || postings.Back() != index)
+            postings.Push(index);
+    };
+
+    // Prefixes of name
+    const String& name = entry.name_;
+    if (name.Length() >= 1)
+        addPosting(PREFIX_PAD, PREFIX_PAD, name[0]);
+    if (name.Length() >= 2)
+        addPosting(PREFIX_PAD, name[0], name[1]);
+
+    // Trigrams of whole key
+    const String& key = entry.key_;
+    for (unsigned i = 0; i + 2 < key.Length(); ++i)
+        addPosting(key[i], key[i + 1], key[i + 2]);
+
+    ++revision_;
+}
+
+void ResourceSearchIndex::RemoveFile(ResourceFileDesc* file)
+{
+    auto iter = slots_.Find(file);
+    if (iter == slots_.End())
+        return;
+
+    Entry& entry = entries_[iter->second_];
+    entry.file_.Reset();
+    entry.key_.Clear();
+    entry.name_.Clear();
+    slots_.Erase(iter);
+    ++numRemoved_;
+    ++revision_;
+
+    if (numRemoved_ >= MIN_REMOVED_TO_COMPACT && numRemoved_ * 2 > entries_.Size())
+        Compact();
+}
+
+void ResourceSearchIndex::Search(const String& query, unsigned maxResults, PODVector<ResourceFileDesc*>& result) const
+{
+    result.Clear();
+
+    // Split query into name and type words
+    Vector<String> words;
+    Vector<String> typeWords;
+    for (const String& token : query.ToLower().Split(' '))
+    {
+        if (!token.StartsWith("type:"))
+            words.Push(token);
+        else if (token.Length() > 5)
+            typeWords.Push(token.Substring(5));
+    }
+    if (words.Empty() && typeWords.Empty())
+        return;
+
+    // Find candidates by the longest word
+    PODVector<unsigned> candidates;
+    if (!words.Empty())
+    {
+        const String* mainWord = &words[0];
+        for (const String& word : words)
+        {
+            if (word.Length() > mainWord->Length())
+                mainWord = &word;
+        }
+
+        PODVector<unsigned> keys;
+        const String& word = *mainWord;
+        if (word.Length() == 1)
+            keys.Push(GetKey(PREFIX_PAD, PREFIX_PAD, word[0]));
+        else if (word.Length() == 2)
+            keys.Push(GetKey(PREFIX_PAD, word[0], word[1]));
+        for (unsigned i = 0; i + 2 < word.Length(); ++i)
+            keys.Push(GetKey(word[i], word[i + 1], word[i + 2]));
+
+        // Intersect posting lists starting from the shortest one
+        PODVector<const PODVector<unsigned>*> postingLists;
+        for (unsigned key : keys)
+        {
+            const PODVector<unsigned>* postings = GetPostings(key);
+            if (!postings)
+                return;
+            postingLists.Push(postings);
+        }
+        Sort(postingLists.Begin(), postingLists.End(),
+            [](const PODVector<unsigned>* lhs, const PODVector<unsigned>* rhs)
+        {
+            return lhs->Size() < rhs->Size();
+        });
+
+        candidates = *postingLists[0];
+        for (unsigned i = 1; i < postingLists.Size() && !candidates.Empty(); ++i)
+            IntersectSorted(candidates, *postingLists[i]);
+    }
+    else
+    {
+        candidates.Resize(entries_.Size());
+        for (unsigned i = 0; i < entries_.Size(); ++i)
+            candidates[i] = i;
+    }
+
+    // Verify candidates, trigrams may match in different order
+    PODVector<SearchMatch> matches;
+    for (unsigned index : candidates)
+    {
+        const Entry& entry = entries_[index];
+        if (!entry.file_)
+            continue;
+
+        bool matched = true;
+        for (unsigned i = 0; i < words.Size() && matched; ++i)
+            matched = IsWordMatched(entry.key_, entry.name_, words[i]);
+        if (matched && !typeWords.Empty())
+        {
+            const String typeName = entry.file_->type_.resourceType_.ToLower();
+            for (unsigned i = 0; i < typeWords.Size() && matched; ++i)
+                matched = typeName.Contains(typeWords[i]);
+        }
+        if (!matched)
+            continue;
+
+        SearchMatch match;
+        match.rank_ = 0;
+        for (const String& word : words)
+            match.rank_ += GetMatchRank(entry.name_, word);
+        match.name_ = &entry.name_;
+        match.file_ = entry.file_;
+        matches.Push(match);
+    }
+
+    Sort(matches.Begin(), matches.End());
+    const unsigned numResults = Min(maxResults, matches.Size());
+    result.Resize(numResults);
+    for (unsigned i = 0; i < numResults; ++i)
+        result[i] = matches[i].file_;
+}
+
+unsigned ResourceSearchIndex::GetKey(char first, char second, char third)
+{
+    return static_cast<unsigned char>(first) << 16
+        | static_cast<unsigned char>(second) << 8
+        | static_cast<unsigned char>(third);
+}
+
+const PODVector<unsigned>* ResourceSearchIndex::GetPostings(unsigned key) const
+{
+    auto iter = postings_.Find(key);
+    return iter != postings_.End() ? &iter->second_ : nullptr;
+}
+
+void ResourceSearchIndex::Compact()
+{
+    Vector<SharedPtr<ResourceFileDesc>> files;
+    files.Reserve(slots_.Size());
+    for (const Entry& entry : entries_)
+    {
+        if (entry.file_)
+            files.Push(entry.file_);
+    }
+
+    Clear();
+    for (ResourceFileDesc* file : files)
+        AddFile(file);
+}
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Container/Ptr.h>
+#include <Urho3D/Container/Str.h>
+
+namespace Urho3D
+{
+
+class ResourceFileDesc;
+
+/// Search index of resource files. Resource keys are indexed by trigrams, first one or two characters of file name are indexed as prefixes.
+class ResourceSearchIndex
+{
+public:
+    /// Construct.
+    ResourceSearchIndex();
+    /// Destruct.
+    ~ResourceSearchIndex();
+
+    /// Remove all files.
+    void Clear();
+    /// Add file.
+    void AddFile(ResourceFileDesc* file);
+    /// Remove file.
+    void RemoveFile(ResourceFileDesc* file);
+    /// Find files matching query, best matches first. Words of query shall be found in resource key, words shorter than
+    /// three characters shall start file name. Matches in file name rank higher than in directory.
+    /// Words prefixed with "type:" shall be found in resource type instead.
+    void Search(const String& query, unsigned maxResults, PODVector<ResourceFileDesc*>& result) const;
+
+    /// Return number of indexed files.
+    unsigned GetNumFiles() const { return slots_.Size(); }
+    /// Return revision that is incremented on every change.
+    unsigned GetRevision() const { return revision_; }
+
+private:
+    /// Indexed file.
+    struct Entry
+    {
+        /// File, null if removed.
+        SharedPtr<ResourceFileDesc> file_;
+        /// Resource key in lower case.
+        String key_;
+        /// File name in lower case.
+        String name_;
+    };
+
+    /// Return trigram key.
+    static unsigned GetKey(char first, char second, char third);
+    /// Return posting list for key, null if missing.
+    const PODVector<unsigned>* GetPostings(unsigned key) const;
+    /// Rebuild index without removed files.
+    void Compact();
+
+private:
+    /// Entries. Removed entries are kept until compaction so that posting lists stay sorted.
+    Vector<Entry> entries_;
+    /// Entry indices of files.
+    HashMap<ResourceFileDesc*, unsigned> slots_;
+    /// Sorted entry indices by trigram key.
+    HashMap<unsigned, PODVector<unsigned>> postings_;
+    /// Number of removed entries.
+    unsigned numRemoved_ = 0;
+    /// Revision.
+    unsigned revision_ = 0;
+};
+
+}
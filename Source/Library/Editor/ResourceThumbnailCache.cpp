@@ -0,0 +1,471 @@
+#include "ResourceThumbnailCache.h"
+#include "ResourceBrowser.h"
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/GraphicsEvents.h>
+#include <Urho3D/Graphics/Light.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/RenderSurface.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Graphics/Texture2D.h>
+#include <Urho3D/Graphics/Viewport.h>
+#include <Urho3D/Graphics/Zone.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Resource/Image.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/ResourceEvents.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace Urho3D
+{
+
+namespace
+{
+
+/// Field of view of preview camera.
+const float PREVIEW_FOV = 45.0f;
+
+/// Create downscaled RGBA copy of image that fits into the square.
+SharedPtr<Image> CreateThumbnail(SharedPtr<Image> image, unsigned size)
+{
+    if (image->IsCompressed())
+        image = image->GetDecompressedImage();
+    if (!image || image->GetWidth() <= 0 || image->GetHeight() <= 0)
+        return nullptr;
+
+    // Reduce with box filter first, so that bilinear sampling doesn't skip pixels
+    const int maxSize = static_cast<int>(size);
+    while (image && Max(image->GetWidth(), image->GetHeight()) >= maxSize * 4)
+        image = image->GetNextLevel();
+    if (!image)
+        return nullptr;
+
+    const float scale = Min(1.0f, static_cast<float>(maxSize) / Max(image->GetWidth(), image->GetHeight()));
+    const int width = Max(1, RoundToInt(image->GetWidth() * scale));
+    const int height = Max(1, RoundToInt(image->GetHeight() * scale));
+
+    auto thumbnail = MakeShared<Image>(image->GetContext());
+    thumbnail->SetSize(width, height, 4);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const float u = (x + 0.5f) / width;
+            const float v = (y + 0.5f) / height;
+            thumbnail->SetPixel(x, y, image->GetPixelBilinear(u, v));
+        }
+    }
+    return thumbnail;
+}
+
+/// Load image from file. Return null on failure.
+SharedPtr<Image> LoadImage(Context* context, const String& fileName)
+{
+    File file(context, fileName);
+    if (!file.IsOpen())
+        return nullptr;
+
+    auto image = MakeShared<Image>(context);
+    if (!image->Load(file))
+        return nullptr;
+    return image;
+}
+
+}
+
+struct ResourceThumbnailCache::ThumbnailWorkItem : public WorkItem
+{
+    /// File. Accessed only by main thread.
+    SharedPtr<ResourceFileDesc> file_;
+    /// File name.
+    String fileName_;
+    /// Resource name.
+    String resourceName_;
+    /// Resource type.
+    StringHash resourceType_;
+    /// Directory of disk cache, empty if disabled.
+    String cacheDir_;
+    /// Size of thumbnail.
+    unsigned thumbnailSize_ = 0;
+    /// Whether the file is decoded as image. Otherwise preview is rendered if thumbnail is missing in disk cache.
+    bool decodeImage_ = false;
+    /// Whether the thumbnail is saved to disk cache instead of being generated.
+    bool saveThumbnail_ = false;
+    /// Thumbnail. Written by worker thread unless saved.
+    SharedPtr<Image> image_;
+    /// File name of thumbnail in disk cache. Written by worker thread.
+    String cacheFileName_;
+};
+
+ResourceThumbnailCache::ResourceThumbnailCache(Context* context)
+    : Object(context)
+    , cache_(GetSubsystem<ResourceCache>())
+{
+    SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(ResourceThumbnailCache, HandleEndFrame));
+    SubscribeToEvent(E_RESOURCEBACKGROUNDLOADED, URHO3D_HANDLER(ResourceThumbnailCache, HandleResourceBackgroundLoaded));
+}
+
+ResourceThumbnailCache::~ResourceThumbnailCache() = default;
+
+void ResourceThumbnailCache::SetCacheDir(const String& cacheDir)
+{
+    cacheDir_ = cacheDir.Empty() ? String::EMPTY : AddTrailingSlash(cacheDir);
+    if (!cacheDir_.Empty())
+        GetSubsystem<FileSystem>()->CreateDir(cacheDir_);
+}
+
+Image* ResourceThumbnailCache::GetThumbnail(ResourceFileDesc& file)
+{
+    const String fileName = GetFileName(file);
+    auto iter = thumbnails_.Find(fileName);
+    if (iter != thumbnails_.End())
+    {
+        iter->second_.lastUse_ = ++useCounter_;
+        return iter->second_.image_;
+    }
+
+    if (!pendingItems_.Contains(fileName))
+        QueueThumbnail(file, fileName);
+    return nullptr;
+}
+
+void ResourceThumbnailCache::InvalidateThumbnail(const ResourceFileDesc& file)
+{
+    // Results of pending items are discarded too
+    const String fileName = GetFileName(file);
+    thumbnails_.Erase(fileName);
+    pendingItems_.Erase(fileName);
+}
+
+void ResourceThumbnailCache::ProcessThumbnailWork(const WorkItem* item, unsigned /*threadIndex*/)
+{
+    // Work item is not touched by main thread until completed
+    ThumbnailWorkItem* thumbnailItem = const_cast<ThumbnailWorkItem*>(static_cast<const ThumbnailWorkItem*>(item));
+    Context* context = static_cast<Context*>(item->aux_);
+
+    if (thumbnailItem->saveThumbnail_)
+    {
+        thumbnailItem->image_->SavePNG(thumbnailItem->cacheFileName_);
+        return;
+    }
+
+    // Look up disk cache first
+    if (!thumbnailItem->cacheDir_.Empty())
+    {
+        FileSystem* fileSystem = context->GetSubsystem<FileSystem>();
+        const unsigned modifiedTime = fileSystem->GetLastModifiedTime(thumbnailItem->fileName_);
+        thumbnailItem->cacheFileName_ = thumbnailItem->cacheDir_ + StringHash(thumbnailItem->fileName_).ToString()
+            + "_" + String(modifiedTime) + "_" + String(thumbnailItem->thumbnailSize_) + ".png";
+
+        if (fileSystem->FileExists(thumbnailItem->cacheFileName_))
+        {
+            SharedPtr<Image> image = LoadImage(context, thumbnailItem->cacheFileName_);
+            if (image && image->GetComponents() == 4)
+            {
+                thumbnailItem->image_ = image;
+                return;
+            }
+        }
+    }
+
+    if (!thumbnailItem->decodeImage_)
+        return;
+
+    if (SharedPtr<Image> image = LoadImage(context, thumbnailItem->fileName_))
+    {
+        thumbnailItem->image_ = CreateThumbnail(image, thumbnailItem->thumbnailSize_);
+        if (thumbnailItem->image_ && !thumbnailItem->cacheFileName_.Empty())
+            thumbnailItem->image_->SavePNG(thumbnailItem->cacheFileName_);
+    }
+}
+
+String ResourceThumbnailCache::GetFileName(const ResourceFileDesc& file) const
+{
+    const Vector<String>& resourceDirs = cache_->GetResourceDirs();
+    if (file.resourceDirIndex_ >= resourceDirs.Size())
+        return String::EMPTY;
+    return AddTrailingSlash(resourceDirs[file.resourceDirIndex_]) + file.GetResourceName();
+}
+
+void ResourceThumbnailCache::QueueThumbnail(ResourceFileDesc& file, const String& fileName)
+{
+    const StringHash objectType = file.type_.objectType_;
+    const bool decodeImage = objectType == Image::GetTypeStatic() || objectType == Texture2D::GetTypeStatic();
+    const bool renderPreview = objectType == Model::GetTypeStatic() || objectType == Material::GetTypeStatic();
+    if (fileName.Empty() || (!decodeImage && !renderPreview))
+        return;
+
+    auto item = MakeShared<ThumbnailWorkItem>();
+    item->workFunction_ = ProcessThumbnailWork;
+    item->aux_ = context_;
+    item->file_ = &file;
+    item->fileName_ = fileName;
+    item->resourceName_ = cache_->SanitateResourceName(file.GetResourceName());
+    item->resourceType_ = objectType;
+    item->cacheDir_ = cacheDir_;
+    item->thumbnailSize_ = thumbnailSize_;
+    item->decodeImage_ = decodeImage;
+    GetSubsystem<WorkQueue>()->AddWorkItem(item);
+
+    workItems_.Push(item);
+    pendingItems_[fileName] = item;
+}
+
+void ResourceThumbnailCache::SetThumbnail(ThumbnailWorkItem& item, Image* image)
+{
+    Thumbnail& thumbnail = thumbnails_[item.fileName_];
+    thumbnail.image_ = image;
+    thumbnail.lastUse_ = ++useCounter_;
+    pendingItems_.Erase(item.fileName_);
+    EvictThumbnails();
+
+    if (image && onThumbnailReady_)
+        onThumbnailReady_(*item.file_);
+}
+
+void ResourceThumbnailCache::EvictThumbnails()
+{
+    while (thumbnails_.Size() > maxThumbnails_)
+    {
+        auto oldest = thumbnails_.Begin();
+        for (auto iter = thumbnails_.Begin(); iter != thumbnails_.End(); ++iter)
+        {
+            if (iter->second_.lastUse_ < oldest->second_.lastUse_)
+                oldest = iter;
+        }
+        thumbnails_.Erase(oldest);
+    }
+}
+
+bool ResourceThumbnailCache::IsPending(ThumbnailWorkItem* item) const
+{
+    auto iter = pendingItems_.Find(item->fileName_);
+    return iter != pendingItems_.End() && iter->second_ == item;
+}
+
+void ResourceThumbnailCache::HandleEndFrame(StringHash /*eventType*/, VariantMap& /*eventData*/)
+{
+    ApplyCompletedItems();
+
+    if (renderItem_ && renderFinished_)
+        FinishRender();
+    if (!renderItem_)
+        StartNextRender();
+}
+
+void ResourceThumbnailCache::HandleResourceBackgroundLoaded(StringHash /*eventType*/, VariantMap& eventData)
+{
+    using namespace ResourceBackgroundLoaded;
+
+    auto iter = loadingItems_.Find(eventData[P_RESOURCENAME].GetString());
+    if (iter == loadingItems_.End())
+        return;
+
+    const Vector<SharedPtr<ThumbnailWorkItem>> items = iter->second_;
+    loadingItems_.Erase(iter);
+
+    const bool success = eventData[P_SUCCESS].GetBool();
+    for (ThumbnailWorkItem* item : items)
+    {
+        if (!IsPending(item))
+            continue;
+        if (success)
+            renderQueue_.Push(SharedPtr<ThumbnailWorkItem>(item));
+        else
+            SetThumbnail(*item, nullptr);
+    }
+}
+
+void ResourceThumbnailCache::HandleEndViewRender(StringHash /*eventType*/, VariantMap& eventData)
+{
+    if (eventData[EndViewRender::P_TEXTURE].GetPtr() == renderTexture_)
+        renderFinished_ = true;
+}
+
+void ResourceThumbnailCache::ApplyCompletedItems()
+{
+    for (unsigned i = 0; i < workItems_.Size();)
+    {
+        ThumbnailWorkItem* item = workItems_[i];
+        if (!item->completed_)
+        {
+            ++i;
+            continue;
+        }
+
+        // Thumbnails missing in disk cache are rendered
+        if (!item->saveThumbnail_ && IsPending(item))
+        {
+            if (item->image_ || item->decodeImage_)
+                SetThumbnail(*item, item->image_);
+            else
+                renderQueue_.Push(SharedPtr<ThumbnailWorkItem>(item));
+        }
+        workItems_.Erase(i);
+    }
+}
+
+void ResourceThumbnailCache::StartNextRender()
+{
+    while (!renderItem_ && !renderQueue_.Empty())
+    {
+        SharedPtr<ThumbnailWorkItem> item = renderQueue_.Front();
+        renderQueue_.Erase(0);
+        if (!IsPending(item))
+            continue;
+
+        // Render resource when it's loaded in background
+        Resource* resource = cache_->GetExistingResource(item->resourceType_, item->resourceName_);
+        if (!resource && !loadingItems_.Contains(item->resourceName_))
+        {
+            if (!cache_->BackgroundLoadResource(item->resourceType_, item->resourceName_))
+            {
+                // Refused background load is done right away
+                resource = cache_->GetResource(item->resourceType_, item->resourceName_, false);
+                if (!resource)
+                {
+                    SetThumbnail(*item, nullptr);
+                    continue;
+                }
+            }
+            else
+            {
+                // Without threading the resource is loaded synchronously and no event is sent
+                resource = cache_->GetExistingResource(item->resourceType_, item->resourceName_);
+            }
+        }
+        if (!resource)
+        {
+            loadingItems_[item->resourceName_].Push(item);
+            continue;
+        }
+
+        if (!SetupPreview(resource))
+        {
+            SetThumbnail(*item, nullptr);
+            continue;
+        }
+
+        renderItem_ = item;
+        renderFinished_ = false;
+        renderTexture_->GetRenderSurface()->QueueUpdate();
+    }
+}
+
+bool ResourceThumbnailCache::SetupPreview(Resource* resource)
+{
+    if (!previewScene_)
+        CreatePreviewScene();
+
+    // Materials are previewed on model
+    if (Model* model = dynamic_cast<Model*>(resource))
+    {
+        previewModel_->SetModel(model);
+        previewModel_->SetMaterial(nullptr);
+    }
+    else if (Material* material = dynamic_cast<Material*>(resource))
+    {
+        Model* model = cache_->GetResource<Model>(materialPreviewModel_);
+        if (!model)
+            return false;
+        previewModel_->SetModel(model);
+        previewModel_->SetMaterial(material);
+    }
+    else
+        return false;
+
+    // Fit model into view
+    const BoundingBox boundingBox = previewModel_->GetModel()->GetBoundingBox();
+    const float radius = Max(boundingBox.HalfSize().Length(), M_EPSILON);
+    const float distance = radius / Sin(PREVIEW_FOV * 0.5f);
+    Camera* camera = cameraNode_->GetComponent<Camera>();
+    camera->SetNearClip(distance * 0.01f);
+    camera->SetFarClip(distance + radius * 2.0f);
+    cameraNode_->SetPosition(boundingBox.Center() + Vector3(1.0f, 1.0f, -1.0f).Normalized() * distance);
+    cameraNode_->LookAt(boundingBox.Center());
+
+    // Thumbnail size may be changed
+    const int size = static_cast<int>(thumbnailSize_);
+    if (renderTexture_->GetWidth() != size)
+    {
+        renderTexture_->SetSize(size, size, Graphics::GetRGBAFormat(), TEXTURE_RENDERTARGET);
+        depthTexture_->SetSize(size, size, Graphics::GetDepthStencilFormat(), TEXTURE_DEPTHSTENCIL);
+
+        RenderSurface* surface = renderTexture_->GetRenderSurface();
+        surface->SetViewport(0, viewport_);
+        surface->SetLinkedDepthStencil(depthTexture_->GetRenderSurface());
+        surface->SetUpdateMode(SURFACE_MANUALUPDATE);
+    }
+    return true;
+}
+
+void ResourceThumbnailCache::CreatePreviewScene()
+{
+    previewScene_ = MakeShared<Scene>(context_);
+    previewScene_->CreateComponent<Octree>();
+
+    Zone* zone = previewScene_->CreateComponent<Zone>();
+    zone->SetBoundingBox(BoundingBox(-M_LARGE_VALUE, M_LARGE_VALUE));
+    zone->SetAmbientColor(Color(0.4f, 0.4f, 0.4f));
+    zone->SetFogColor(Color(0.2f, 0.2f, 0.2f, 0.0f));
+    zone->SetFogStart(M_LARGE_VALUE);
+    zone->SetFogEnd(M_LARGE_VALUE);
+
+    Node* lightNode = previewScene_->CreateChild("Light");
+    lightNode->SetDirection(Vector3(0.6f, -1.0f, 0.8f));
+    lightNode->CreateComponent<Light>()->SetLightType(LIGHT_DIRECTIONAL);
+
+    cameraNode_ = previewScene_->CreateChild("Camera");
+    Camera* camera = cameraNode_->CreateComponent<Camera>();
+    camera->SetFov(PREVIEW_FOV);
+
+    previewModel_ = previewScene_->CreateChild("Model")->CreateComponent<StaticModel>();
+
+    renderTexture_ = MakeShared<Texture2D>(context_);
+    renderTexture_->SetNumLevels(1);
+    depthTexture_ = MakeShared<Texture2D>(context_);
+    depthTexture_->SetNumLevels(1);
+    viewport_ = MakeShared<Viewport>(context_, previewScene_, camera);
+
+    SubscribeToEvent(E_ENDVIEWRENDER, URHO3D_HANDLER(ResourceThumbnailCache, HandleEndViewRender));
+}
+
+void ResourceThumbnailCache::FinishRender()
+{
+    SharedPtr<ThumbnailWorkItem> item = renderItem_;
+    renderItem_.Reset();
+    renderFinished_ = false;
+
+    // Don't keep previewed resource alive
+    previewModel_->SetModel(nullptr);
+    previewModel_->SetMaterial(nullptr);
+
+    if (!IsPending(item))
+        return;
+
+    auto image = MakeShared<Image>(context_);
+    if (!renderTexture_->GetImage(*image))
+    {
+        SetThumbnail(*item, nullptr);
+        return;
+    }
+
+    SetThumbnail(*item, image);
+
+    // Save rendered thumbnail in background
+    if (!item->cacheFileName_.Empty())
+    {
+        item->image_ = image;
+        item->saveThumbnail_ = true;
+        item->completed_ = false;
+        GetSubsystem<WorkQueue>()->AddWorkItem(item);
+        workItems_.Push(item);
+    }
+}
+
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+
+namespace Urho3D
+{
+
+class Image;
+class Node;
+class Resource;
+class ResourceCache;
+class Scene;
+class StaticModel;
+class Texture2D;
+class Viewport;
+struct WorkItem;
+
+class ResourceFileDesc;
+
+/// Thumbnails of resource files. Images are decoded and disk cache is accessed by worker threads.
+/// Models and materials are rendered on main thread, one per frame.
+class ResourceThumbnailCache : public Object
+{
+    URHO3D_OBJECT(ResourceThumbnailCache, Object);
+
+public:
+    /// Construct.
+    ResourceThumbnailCache(Context* context);
+    /// Destruct.
+    ~ResourceThumbnailCache() override;
+
+    /// Set size of thumbnails in pixels. Takes effect for new thumbnails.
+    void SetThumbnailSize(unsigned size) { thumbnailSize_ = Max(1u, size); }
+    /// Set maximum number of thumbnails kept in memory.
+    void SetMaxThumbnails(unsigned maxThumbnails) { maxThumbnails_ = Max(1u, maxThumbnails); }
+    /// Set directory of disk cache. Thumbnails are kept in memory only if empty.
+    void SetCacheDir(const String& cacheDir);
+    /// Set model used to preview materials.
+    void SetMaterialPreviewModel(const String& modelName) { materialPreviewModel_ = modelName; }
+    /// Return thumbnail of file. Generation is queued if thumbnail is not ready yet.
+    Image* GetThumbnail(ResourceFileDesc& file);
+    /// Forget thumbnail of changed file.
+    void InvalidateThumbnail(const ResourceFileDesc& file);
+
+public:
+    /// Called when thumbnail of file is ready.
+    std::function<void(ResourceFileDesc& file)> onThumbnailReady_;
+
+private:
+    /// Work item that generates, loads or saves thumbnail.
+    struct ThumbnailWorkItem;
+
+    /// Thumbnail in memory.
+    struct Thumbnail
+    {
+        /// Image, null if thumbnail cannot be generated.
+        SharedPtr<Image> image_;
+        /// Time of last use.
+        unsigned lastUse_ = 0;
+    };
+
+    /// Generate, load or save thumbnail. Called from worker thread.
+    static void ProcessThumbnailWork(const WorkItem* item, unsigned threadIndex);
+
+    /// Return file name of resource file.
+    String GetFileName(const ResourceFileDesc& file) const;
+    /// Queue thumbnail generation if file type is supported.
+    void QueueThumbnail(ResourceFileDesc& file, const String& fileName);
+    /// Store generated thumbnail and notify about it.
+    void SetThumbnail(ThumbnailWorkItem& item, Image* image);
+    /// Remove least recently used thumbnails.
+    void EvictThumbnails();
+    /// Return whether the item is still expected.
+    bool IsPending(ThumbnailWorkItem* item) const;
+
+    /// Handle end of frame.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+    /// Handle finished background loading of previewed resource.
+    void HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData);
+    /// Handle finished rendering of preview.
+    void HandleEndViewRender(StringHash eventType, VariantMap& eventData);
+    /// Apply results of completed work items.
+    void ApplyCompletedItems();
+    /// Start rendering of next preview.
+    void StartNextRender();
+    /// Setup preview scene for resource. Return false if resource cannot be previewed.
+    bool SetupPreview(Resource* resource);
+    /// Create preview scene.
+    void CreatePreviewScene();
+    /// Read back rendered preview.
+    void FinishRender();
+
+private:
+    ResourceCache* cache_ = nullptr;
+    /// Size of thumbnails in pixels.
+    unsigned thumbnailSize_ = 64;
+    /// Maximum number of thumbnails kept in memory.
+    unsigned maxThumbnails_ = 1024;
+    /// Directory of disk cache.
+    String cacheDir_;
+    /// Model used to preview materials.
+    String materialPreviewModel_ = "Models/Sphere.mdl";
+
+    /// Thumbnails by file name.
+    HashMap<String, Thumbnail> thumbnails_;
+    /// Counter of thumbnail uses.
+    unsigned useCounter_ = 0;
+    /// Expected work items by file name.
+    HashMap<String, SharedPtr<ThumbnailWorkItem>> pendingItems_;
+    /// Work items queued in work queue.
+    Vector<SharedPtr<ThumbnailWorkItem>> workItems_;
+    /// Work items waiting for preview rendering.
+    Vector<SharedPtr<ThumbnailWorkItem>> renderQueue_;
+    /// Work items waiting for background loading of resource, by resource name.
+    HashMap<String, Vector<SharedPtr<ThumbnailWorkItem>>> loadingItems_;
+    /// Work item whose preview is rendered.
+    SharedPtr<ThumbnailWorkItem> renderItem_;
+    /// Whether the preview is rendered.
+    bool renderFinished_ = false;
+
+    /// Preview scene.
+    SharedPtr<Scene> previewScene_;
+    /// Preview camera node.
+    Node* cameraNode_ = nullptr;
+    /// Previewed model.
+    StaticModel* previewModel_ = nullptr;
+    /// Preview render target.
+    SharedPtr<Texture2D> renderTexture_;
+    /// Preview depth stencil.
+    SharedPtr<Texture2D> depthTexture_;
+    /// Preview viewport.
+    SharedPtr<Viewport> viewport_;
+};
+
+}
@@ -30,25 +30,31 @@
 namespace Urho3D
 {
 
+void Selection::BeginChange()
+{
+    ++changeDepth_;
+}
+
+void Selection::EndChange()
+{
+    assert(changeDepth_ > 0);
+    --changeDepth_;
+    UpdateChangedSelection();
+}
+
 void Selection::ClearSelection()
 {
-    selectedObjectsVector_.Clear();
-    selectedObjectsSet_.Clear();
+    EraseAllObjects();
     UpdateChangedSelection();
 }
 
 void Selection::SetSelection(const ObjectVector& objects)
 {
-    selectedObjectsVector_.Clear();
-    selectedObjectsSet_.Clear();
+    EraseAllObjects();
     for (Object* object : objects)
     {
         if (object)
-        {
-            WeakPtr<Object> weakObject(object);
-            selectedObjectsVector_.Push(weakObject);
-            selectedObjectsSet_.Insert(weakObject);
-        }
+            InsertObject(object);
     }
 
     UpdateChangedSelection();
@@ -57,22 +63,16 @@ void Selection::SetSelection(const ObjectVector& objects)
 void Selection::SelectObject(Object* object, SelectionAction action, bool clearSelection)
 {
     if (clearSelection)
-    {
-        selectedObjectsVector_.Clear();
-        selectedObjectsSet_.Clear();
-    }
+        EraseAllObjects();
 
-    WeakPtr<Object> weakObject(object);
-    const bool wasSelected = selectedObjectsSet_.Contains(weakObject);
-    if (action != SelectionAction::Select && wasSelected)
+    if (object)
     {
-        selectedObjectsSet_.Erase(weakObject);
-        selectedObjectsVector_.Remove(weakObject);
-    }
-    if (action != SelectionAction::Deselect && !wasSelected)
-    {
-        selectedObjectsSet_.Insert(weakObject);
-        selectedObjectsVector_.Push(weakObject);
+        WeakPtr<Object> weakObject(object);
+        const bool wasSelected = entries_.Contains(weakObject);
+        if (action != SelectionAction::Select && wasSelected)
+            EraseObject(weakObject);
+        if (action != SelectionAction::Deselect && !wasSelected)
+            InsertObject(object);
     }
 
     UpdateChangedSelection();
@@ -119,30 +119,214 @@ Component* Selection::GetHoveredComponent() const
     return dynamic_cast<Component*>(hoveredObject_);
 }
 
-void Selection::UpdateChangedSelection()
+bool Selection::InsertObject(Object* object)
 {
+    WeakPtr<Object> weakObject(object);
+    if (entries_.Contains(weakObject))
+        return false;
+
+    RecordChange(weakObject, false);
+
+    ObjectEntry entry;
+    entry.objectIndex_ = selectedObjectsVector_.Size();
+    selectedObjectsVector_.Push(weakObject);
+    selectedObjectsSet_.Insert(weakObject);
+
+    if (Node* node = dynamic_cast<Node*>(object))
+    {
+        WeakPtr<Node> weakNode(node);
+        entry.nodeIndex_ = selectedNodes_.Size();
+        selectedNodes_.Push(weakNode);
+        nodeOwners_.Push(weakObject);
+        entry.nodeOrComponentIndex_ = selectedNodesAndComponents_.Size();
+        selectedNodesAndComponents_.Push(weakNode);
+        nodeOrComponentOwners_.Push(weakObject);
+    }
+    else if (Component* component = dynamic_cast<Component*>(object))
+    {
+        WeakPtr<Component> weakComponent(component);
+        WeakPtr<Node> weakNode(component->GetNode());
+        entry.componentIndex_ = selectedComponents_.Size();
+        selectedComponents_.Push(weakComponent);
+        componentOwners_.Push(weakObject);
+        entry.nodeOrComponentIndex_ = selectedNodesAndComponents_.Size();
+        selectedNodesAndComponents_.Push(weakNode);
+        nodeOrComponentOwners_.Push(weakObject);
+    }
+
+    entries_[weakObject] = entry;
+    return true;
+}
+
+bool Selection::EraseObject(const WeakPtr<Object>& object)
+{
+    auto iter = entries_.Find(object);
+    if (iter == entries_.End())
+        return false;
+
+    RecordChange(object, true);
+
+    const ObjectEntry entry = iter->second_;
+    entries_.Erase(iter);
+
+    // Leave hole in order to keep order of selected objects
+    selectedObjectsVector_[entry.objectIndex_].Reset();
+    selectedObjectsSet_.Erase(object);
+    ++numHoles_;
+
+    // Order of secondary lists doesn't matter
+    if (entry.nodeIndex_ != M_MAX_UNSIGNED)
+        SwapRemove(selectedNodes_, nodeOwners_, entry.nodeIndex_, &ObjectEntry::nodeIndex_);
+    if (entry.componentIndex_ != M_MAX_UNSIGNED)
+        SwapRemove(selectedComponents_, componentOwners_, entry.componentIndex_, &ObjectEntry::componentIndex_);
+    if (entry.nodeOrComponentIndex_ != M_MAX_UNSIGNED)
+        SwapRemove(selectedNodesAndComponents_, nodeOrComponentOwners_, entry.nodeOrComponentIndex_, &ObjectEntry::nodeOrComponentIndex_);
+
+    return true;
+}
+
+void Selection::EraseAllObjects()
+{
+    for (const WeakPtr<Object>& object : selectedObjectsVector_)
+    {
+        // Skip holes
+        if (object)
+            RecordChange(object, true);
+    }
+
+    selectedObjectsVector_.Clear();
+    selectedObjectsSet_.Clear();
+    entries_.Clear();
+    numHoles_ = 0;
+
     selectedNodes_.Clear();
     selectedComponents_.Clear();
     selectedNodesAndComponents_.Clear();
-    for (Object* object : selectedObjectsVector_)
+    nodeOwners_.Clear();
+    componentOwners_.Clear();
+    nodeOrComponentOwners_.Clear();
+}
+
+template <class T> void Selection::SwapRemove(Vector<T>& elements, ObjectVector& owners, unsigned index, unsigned ObjectEntry::*entryIndex)
+{
+    const unsigned lastIndex = elements.Size() - 1;
+    if (index != lastIndex)
     {
-        if (Node* node = dynamic_cast<Node*>(object))
-        {
-            WeakPtr<Node> weakNode(node);
-            selectedNodes_.Push(weakNode);
-            selectedNodesAndComponents_.Push(weakNode);
-        }
-        if (Component* component = dynamic_cast<Component*>(object))
+        elements[index] = elements[lastIndex];
+        owners[index] = owners[lastIndex];
+        entries_[owners[index]].*entryIndex = index;
+    }
+    elements.Pop();
+    owners.Pop();
+}
+
+void Selection::RecordChange(const WeakPtr<Object>& object, bool wasSelected)
+{
+    if (!changedObjects_.Contains(object))
+    {
+        changedObjects_[object] = wasSelected;
+        changedObjectsOrder_.Push(object);
+    }
+}
+
+void Selection::CompactObjects()
+{
+    if (numHoles_ == 0)
+        return;
+
+    unsigned numObjects = 0;
+    for (unsigned i = 0; i < selectedObjectsVector_.Size(); ++i)
+    {
+        // Holes are not in the map
+        auto iter = entries_.Find(selectedObjectsVector_[i]);
+        if (iter == entries_.End())
+            continue;
+
+        iter->second_.objectIndex_ = numObjects;
+        if (numObjects != i)
+            selectedObjectsVector_[numObjects] = selectedObjectsVector_[i];
+        ++numObjects;
+    }
+
+    selectedObjectsVector_.Resize(numObjects);
+    numHoles_ = 0;
+}
+
+void Selection::UpdateChangedSelection()
+{
+    if (changeDepth_ > 0)
+        return;
+
+    // Compact only when holes dominate, so deselecting objects one by one stays linear in total
+    if (numHoles_ * 2 > selectedObjectsVector_.Size())
+        CompactObjects();
+
+    // Objects changed back and forth are not reported
+    ObjectVector addedObjects;
+    ObjectVector removedObjects;
+    for (const WeakPtr<Object>& object : changedObjectsOrder_)
+    {
+        const bool wasSelected = changedObjects_[object];
+        const bool isSelected = entries_.Contains(object);
+        if (!wasSelected && isSelected)
+            addedObjects.Push(object);
+        else if (wasSelected && !isSelected)
+            removedObjects.Push(object);
+    }
+    changedObjects_.Clear();
+    changedObjectsOrder_.Clear();
+
+    if ((!addedObjects.Empty() || !removedObjects.Empty()) && onSelectionChanged_)
+        onSelectionChanged_(addedObjects, removedObjects);
+}
+
+void Selection::GetTopmostNodes(NodeVector& result) const
+{
+    result.Clear();
+
+    HashSet<Node*> selectedNodes;
+    for (Node* node : selectedNodesAndComponents_)
+    {
+        if (node)
+            selectedNodes.Insert(node);
+    }
+
+    // Whether the node is selected or has selected ancestor, shared between nodes with common ancestors
+    HashMap<Node*, bool> coveredNodes;
+    PODVector<Node*> path;
+    auto isCovered = [&](Node* node)
+    {
+        path.Clear();
+        bool covered = false;
+        for (; node; node = node->GetParent())
         {
-            WeakPtr<Component> weakComponent(component);
-            WeakPtr<Node> weakNode(component->GetNode());
-            selectedComponents_.Push(weakComponent);
-            selectedNodesAndComponents_.Push(weakNode);
+            auto iter = coveredNodes.Find(node);
+            if (iter != coveredNodes.End())
+            {
+                covered = iter->second_;
+                break;
+            }
+            if (selectedNodes.Contains(node))
+            {
+                covered = true;
+                break;
+            }
+            path.Push(node);
         }
-    }
+        for (Node* pathNode : path)
+            coveredNodes[pathNode] = covered;
+        return covered;
+    };
 
-    if (onSelectionChanged_)
-        onSelectionChanged_();
+    HashSet<Node*> addedNodes;
+    for (Node* node : selectedNodesAndComponents_)
+    {
+        if (!node || addedNodes.Contains(node) || isCovered(node->GetParent()))
+            continue;
+
+        addedNodes.Insert(node);
+        result.Push(WeakPtr<Node>(node));
+    }
 }
 
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Urho3D/Core/Object.h>
+#include <Urho3D/Container/HashMap.h>
 #include <Urho3D/Container/HashSet.h>
 // #include "SceneOverlay.h"
 // #include "../Core/Document.h"
@@ -48,6 +49,10 @@ public:
     /// Construct.
     Selection(Context* context) : Object(context) { }
 
+    /// Begin selection change. Notification is deferred until the outermost change is ended.
+    void BeginChange();
+    /// End selection change and notify about all changes at once.
+    void EndChange();
     /// Clear selection.
     void ClearSelection();
     /// Select objects.
@@ -59,8 +64,10 @@ public:
 
     /// Return whether the object is selected.
     bool IsSelected(Object* object) const { return selectedObjectsSet_.Contains(WeakPtr<Object>(object)); }
-    /// Get vector of selected objects.
-    const ObjectVector& GetObjects() const { return selectedObjectsVector_; }
+    /// Get vector of selected objects. Removes holes left by deselected objects, so it is linear after deselection.
+    const ObjectVector& GetObjects() { CompactObjects(); return selectedObjectsVector_; }
+    /// Get number of selected objects.
+    unsigned GetNumObjects() const { return selectedObjectsSet_.Size(); }
     /// Get set of selected objects.
     const ObjectSet& GetObjectsSet() const { return selectedObjectsSet_; }
 
@@ -70,6 +77,9 @@ public:
     const ComponentVector& GetComponents() const { return selectedComponents_; }
     /// Get selected nodes and components.
     const NodeVector& GetNodesAndComponents() const { return selectedNodesAndComponents_; }
+    /// Get top-most selected nodes and nodes of selected components. Nodes with selected ancestors are excluded.
+    /// Not cached because scene hierarchy may change without selection change.
+    void GetTopmostNodes(NodeVector& result) const;
     /// Get center point of selected nodes.
     Vector3 GetSelectedCenter();
     /// Get hovered object.
@@ -80,18 +90,47 @@ public:
     Component* GetHoveredComponent() const;
 
 public:
-    /// Called when selection is changed.
-    std::function<void()> onSelectionChanged_;
+    /// Called when selection is changed. Receives objects added to and removed from selection.
+    std::function<void(const ObjectVector& addedObjects, const ObjectVector& removedObjects)> onSelectionChanged_;
 
 private:
-    /// Gather secondary selection lists.
+    /// Positions of selected object in selection lists.
+    struct ObjectEntry
+    {
+        /// Index in vector of selected objects.
+        unsigned objectIndex_ = M_MAX_UNSIGNED;
+        /// Index in vector of selected nodes.
+        unsigned nodeIndex_ = M_MAX_UNSIGNED;
+        /// Index in vector of selected components.
+        unsigned componentIndex_ = M_MAX_UNSIGNED;
+        /// Index in vector of selected nodes and components.
+        unsigned nodeOrComponentIndex_ = M_MAX_UNSIGNED;
+    };
+
+    /// Add object to selection lists. Return false if already selected.
+    bool InsertObject(Object* object);
+    /// Remove object from selection lists. Return false if not selected.
+    bool EraseObject(const WeakPtr<Object>& object);
+    /// Remove all objects from selection lists.
+    void EraseAllObjects();
+    /// Remove element of secondary selection list by replacing it with the last one.
+    template <class T> void SwapRemove(Vector<T>& elements, ObjectVector& owners, unsigned index, unsigned ObjectEntry::*entryIndex);
+    /// Remember selection state of object before the first change.
+    void RecordChange(const WeakPtr<Object>& object, bool wasSelected);
+    /// Remove holes left by erased objects from vector of selected objects.
+    void CompactObjects();
+    /// Finalize selection lists and notify about changes.
     void UpdateChangedSelection();
 
 private:
-    /// Vector of selected objects.
+    /// Vector of selected objects. May contain holes until compacted. Holes are compacted lazily, so use GetObjects().
     ObjectVector selectedObjectsVector_;
     /// Set of selected objects.
     ObjectSet selectedObjectsSet_;
+    /// Positions of selected objects in selection lists.
+    HashMap<WeakPtr<Object>, ObjectEntry> entries_;
+    /// Number of holes in vector of selected objects.
+    unsigned numHoles_ = 0;
 
     /// Selected nodes.
     NodeVector selectedNodes_;
@@ -99,6 +138,18 @@ private:
     ComponentVector selectedComponents_;
     /// Selected nodes and components.
     NodeVector selectedNodesAndComponents_;
+    /// Objects owning elements of selected nodes.
+    ObjectVector nodeOwners_;
+    /// Objects owning elements of selected components.
+    ObjectVector componentOwners_;
+    /// Objects owning elements of selected nodes and components.
+    ObjectVector nodeOrComponentOwners_;
+    /// Depth of nested selection changes.
+    unsigned changeDepth_ = 0;
+    /// Selection state of changed objects before the change.
+    HashMap<WeakPtr<Object>, bool> changedObjects_;
+    /// Changed objects in order of change.
+    ObjectVector changedObjectsOrder_;
     /// Hovered object.
     Object* hoveredObject_ = nullptr;
     /// Last center of selected nodes and components.
@@ -107,5 +158,24 @@ private:
 
 };
 
+/// Selection change scope. Notifies about all changes made within the scope once.
+class SelectionChangeScope
+{
+public:
+    /// Construct and begin change.
+    explicit SelectionChangeScope(Selection* selection) : selection_(selection) { selection_->BeginChange(); }
+    /// Destruct and end change.
+    ~SelectionChangeScope() { selection_->EndChange(); }
+
+private:
+    /// Prohibit copy.
+    SelectionChangeScope(const SelectionChangeScope&) = delete;
+    /// Prohibit copy.
+    SelectionChangeScope& operator=(const SelectionChangeScope&) = delete;
+
+    /// Selection.
+    SharedPtr<Selection> selection_;
+};
+
 }
 
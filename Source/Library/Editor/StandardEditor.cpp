@@ -1,4 +1,5 @@
 #include "StandardEditor.h"
+#include "EditorEvents.h"
 
 #include <Urho3D/AngelScript/ScriptFile.h>
 #include <Urho3D/Audio/Sound.h>
@@ -11,6 +12,7 @@
 #include <Urho3D/Graphics/Texture2D.h>
 #include <Urho3D/Graphics/Texture3D.h>
 #include <Urho3D/Graphics/TextureCube.h>
+#include <Urho3D/IO/FileSystem.h>
 #include <Urho3D/LuaScript/LuaFile.h>
 #include <Urho3D/Resource/ResourceCache.h>
 #include <Urho3D/Scene/Scene.h>
@@ -152,9 +154,15 @@ StandardEditor::StandardEditor(AbstractMainWindow* mainWindow, bool blenderHotke
 
     gizmo_->onChanged_ = [=]()
     {
+        objectSelector_->MarkSceneChanged();
         inspector_->Refresh();
     };
 
+    SubscribeToEvent(E_EDITORATTRIBUTESCHANGED, [=](StringHash /*eventType*/, VariantMap& /*eventData*/)
+    {
+        objectSelector_->MarkSceneChanged();
+    });
+
     {
         auto scene = MakeShared<Scene>(context_);
         mainWindow_->InsertDocument(CreateSceneDocument(scene), "New Scene", 0);
@@ -182,6 +190,12 @@ StandardEditor::StandardEditor(AbstractMainWindow* mainWindow, bool blenderHotke
     editor_->AddOverlay(debugGeometryRenderer_);
 
     InitializeResourceLayers();
+    const String projectCacheDir = GetProjectCacheDir();
+    if (!projectCacheDir.Empty())
+    {
+        resourceBrowser_->SetTypeIndexFileName(projectCacheDir + "ResourceTypeIndex.bin");
+        resourceBrowser_->GetThumbnailCache()->SetCacheDir(projectCacheDir + "Thumbnails");
+    }
     resourceBrowser_->ScanResources();
     resourceBrowser_->onResourceDoubleClicked_ = [=](const ResourceFileDesc& file)
     {
@@ -262,6 +276,27 @@ void StandardEditor::InitializeResourceLayers()
     resourceBrowser_->AddLayer(MakeExtensionLayer<XMLFile>(".xml"));
 }
 
+String StandardEditor::GetProjectCacheDir() const
+{
+    FileSystem* fileSystem = GetSubsystem<FileSystem>();
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+
+    // Program directory may be read-only and is shared between projects
+    const String preferencesDir = fileSystem->GetAppPreferencesDir("urho3d", "Editor");
+    if (preferencesDir.Empty())
+        return String::EMPTY;
+
+    // Project is identified by its resource directories
+    String projectKey;
+    for (const String& resourceDir : cache->GetResourceDirs())
+        projectKey += resourceDir + ";";
+
+    const String projectCacheDir = AddTrailingSlash(preferencesDir) + StringHash(projectKey).ToString() + "/";
+    if (!fileSystem->CreateDir(projectCacheDir))
+        return String::EMPTY;
+    return projectCacheDir;
+}
+
 void StandardEditor::SetupActions()
 {
     // Undo
@@ -271,6 +306,7 @@ void StandardEditor::SetupActions()
         if (currentDocument_ && currentDocument_->undoStack_)
         {
             currentDocument_->undoStack_->Undo();
+            objectSelector_->MarkSceneChanged();
             inspector_->Refresh();
         }
     },
@@ -292,6 +328,7 @@ void StandardEditor::SetupActions()
         if (currentDocument_ && currentDocument_->undoStack_)
         {
             currentDocument_->undoStack_->Redo();
+            objectSelector_->MarkSceneChanged();
             inspector_->Refresh();
         }
     },
@@ -334,6 +371,19 @@ void StandardEditor::SetupActions()
             text = currentScene->IsUpdateEnabled() ? "Pause Scene" : "Play Scene";
         }
     });
+
+    // Picking method
+    mainWindow_->RegisterAction("SceneTogglePickingMethod",
+        [=]()
+    {
+        const bool useIdBuffer = objectSelector_->GetPickingMethod() != ObjectPickingMethod::IdBuffer;
+        objectSelector_->SetPickingMethod(useIdBuffer ? ObjectPickingMethod::IdBuffer : ObjectPickingMethod::Raycast);
+    },
+        [=](String& text)
+    {
+        text = objectSelector_->GetPickingMethod() == ObjectPickingMethod::IdBuffer
+            ? "Use Raycast Picking" : "Use ID Buffer Picking";
+    });
 }
 
 void StandardEditor::SetupMenu()
@@ -352,6 +402,7 @@ void StandardEditor::SetupMenu()
         AbstractMenuItem("Scene",
         {
             { "Play Scene", KeyBinding::Key(KEY_F5), mainWindow_->FindAction("SceneTogglePlay") },
+            { "Use ID Buffer Picking", KeyBinding::EMPTY, mainWindow_->FindAction("SceneTogglePickingMethod") },
         })
     }));
 }
@@ -487,9 +538,9 @@ SharedPtr<StandardDocument> StandardEditor::CreateSceneDocument(Scene* scene, co
     hierarchy->SetScene(document->scene_);
     hierarchy->SetSelection(document->selection_);
 
-    document->selection_->onSelectionChanged_ = [=]()
+    document->selection_->onSelectionChanged_ = [=](const Selection::ObjectVector& addedObjects, const Selection::ObjectVector& removedObjects)
     {
-        hierarchy->RefreshSelection();
+        hierarchy->RefreshSelection(addedObjects, removedObjects);
         UpdateInspector();
     };
 
@@ -520,6 +571,7 @@ SharedPtr<Inspectable> StandardEditor::CreateNodesInspector(const Selection::Nod
     // Create nodes panel
     auto nodesPanel = MakeShared<MultipleSerializableInspectorPanel>(context_);
     nodesPanel->SetMaxLabelLength(maxInspectorLabelLength_);
+    nodesPanel->SetUndoStack(currentDocument_->undoStack_);
     for (Node* node : nodes)
         if (!nodesPanel->AddObject(node))
             return nullptr;
@@ -531,6 +583,7 @@ SharedPtr<Inspectable> StandardEditor::CreateNodesInspector(const Selection::Nod
     {
         auto componentsPanel = MakeShared<MultipleSerializableInspectorPanel>(context_);
         componentsPanel->SetMaxLabelLength(maxInspectorLabelLength_);
+        componentsPanel->SetUndoStack(currentDocument_->undoStack_);
         for (Node* node : nodes)
             if (!componentsPanel->AddObject(GetNodeComponent(node, componentType)))
                 return nullptr;
@@ -547,6 +600,7 @@ SharedPtr<Inspectable> StandardEditor::CreateComponentsInspector(const Selection
     // Create nodes panel
     auto nodesPanel = MakeShared<MultipleSerializableInspectorPanel>(context_);
     nodesPanel->SetMaxLabelLength(maxInspectorLabelLength_);
+    nodesPanel->SetUndoStack(currentDocument_->undoStack_);
     for (Component* component : components)
         if (!nodesPanel->AddObject(component->GetNode()))
             return nullptr;
@@ -555,6 +609,7 @@ SharedPtr<Inspectable> StandardEditor::CreateComponentsInspector(const Selection
     // Create components panel
     auto componentsPanel = MakeShared<MultipleSerializableInspectorPanel>(context_);
     componentsPanel->SetMaxLabelLength(maxInspectorLabelLength_);
+    componentsPanel->SetUndoStack(currentDocument_->undoStack_);
     for (Component* component : components)
         if (!componentsPanel->AddObject(component))
             return nullptr;
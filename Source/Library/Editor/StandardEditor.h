@@ -43,6 +43,8 @@ public:
 
 private:
     void InitializeResourceLayers();
+    /// Return per-user cache directory of current project. Empty if there's no preferences directory.
+    String GetProjectCacheDir() const;
     void SetupActions();
     void SetupMenu();
     void SetupControlsGeneric();
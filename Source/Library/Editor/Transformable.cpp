@@ -1,6 +1,7 @@
 #include "Transformable.h"
 
 #include "Selection.h"
+#include <Urho3D/Core/WorkQueue.h>
 #include <Urho3D/Scene/Scene.h>
 
 namespace Urho3D
@@ -41,6 +42,10 @@ bool SelectionTransform::IsEmpty()
 
 Vector3 SelectionTransform::GetPosition()
 {
+    // Pivot is cached while transformation is in progress
+    if (!nodes_.Empty())
+        return pivot_;
+
     const Selection::NodeVector& nodes = selection_->GetNodesAndComponents();
 
     Vector3 center;
@@ -62,94 +67,225 @@ Quaternion SelectionTransform::GetRotation()
 
 void SelectionTransform::StartTransformation()
 {
-    const Selection::NodeVector& selection = selection_->GetNodesAndComponents();
-
     nodes_.Clear();
-    for (Node* node : selection)
-        nodes_.Push(WeakPtr<Node>(node));
+    pivot_ = GetPosition();
+    transformKinds_ = 0;
+
+    // Transform only disjoint subtrees
+    selection_->GetTopmostNodes(nodes_);
+
+    const unsigned numNodes = nodes_.Size();
+    initialTransforms_.Resize(numNodes);
+    worldPositions_.Resize(numNodes);
+    worldRotations_.Resize(numNodes);
+    parentInverseTransforms_.Resize(numNodes);
+    parentInverseRotations_.Resize(numNodes);
+    localPositions_.Resize(numNodes);
+    localRotations_.Resize(numNodes);
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        Node& node = *nodes_[i];
+        initialTransforms_[i].Define(node);
+        worldPositions_[i] = node.GetWorldPosition();
+        worldRotations_[i] = node.GetWorldRotation();
 
-    initialTransforms_.Resize(selection.Size());
-    for (unsigned i = 0; i < selection.Size(); ++i)
-        initialTransforms_[i].Define(*nodes_[i]);
+        Node* parent = node.GetParent();
+        parentInverseTransforms_[i] = parent ? parent->GetWorldTransform().Inverse() : Matrix3x4::IDENTITY;
+        parentInverseRotations_[i] = parent ? parent->GetWorldRotation().Inverse() : Quaternion::IDENTITY;
+    }
 }
 
 void SelectionTransform::ApplyPositionChange(const Vector3& delta)
 {
-    for (Node* node : nodes_)
-        node->SetWorldPosition(node->GetWorldPosition() + delta);
+    transformKinds_ |= NTK_POSITION;
+    pivot_ += delta;
+    for (Vector3& position : worldPositions_)
+        position += delta;
+
+    UpdateLocalTransforms();
+    ApplyLocalTransforms();
 }
 
 void SelectionTransform::ApplyRotationChange(const Quaternion& delta)
 {
-    const Vector3 origin = GetPosition();
-    for (Node* node : nodes_)
+    transformKinds_ |= NTK_ROTATION;
+    for (unsigned i = 0; i < worldPositions_.Size(); ++i)
     {
-        const Vector3 offset = node->GetWorldPosition() - origin;
-        node->SetWorldRotation(delta * node->GetWorldRotation());
-        node->SetWorldPosition(origin + delta * offset);
+        worldPositions_[i] = pivot_ + delta * (worldPositions_[i] - pivot_);
+        worldRotations_[i] = delta * worldRotations_[i];
     }
+
+    UpdateLocalTransforms();
+    ApplyLocalTransforms();
 }
 
 void SelectionTransform::ApplyScaleChange(const Vector3& delta)
 {
+    transformKinds_ |= NTK_SCALE;
     for (Node* node : nodes_)
-        node->SetScale(node->GetScale() + delta);
+    {
+        if (node)
+            node->SetScale(node->GetScale() + delta);
+    }
 }
 
 void SelectionTransform::SnapScale(float step)
 {
+    transformKinds_ |= NTK_SCALE;
     for (Node* node : nodes_)
-        node->SetScale(SnapVector(node->GetScale(), step));
+    {
+        if (node)
+            node->SetScale(SnapVector(node->GetScale(), step));
+    }
 }
 
-void SelectionTransform::EndTransformation()
+void SelectionTransform::EndTransformation(bool mergeable)
 {
-    if (!undoStack_ || nodes_.Empty())
-        return;
+    // Cached pivot is used while nodes are not empty, so they are cleared on every path
+    if (undoStack_ && !nodes_.Empty())
+        PushUndoCommand(mergeable);
 
-    auto commandGroup = MakeShared<UndoCommandGroup>(context_, "Node Transforms");
+    nodes_.Clear();
+    initialTransforms_.Clear();
+}
+
+void SelectionTransform::PushUndoCommand(bool mergeable)
+{
+    auto command = MakeShared<SelectionTransformChanged>(context_, scene_, transformKinds_);
+    command->Reserve(nodes_.Size());
     for (unsigned i = 0; i < nodes_.Size(); ++i)
     {
-        Node* node = nodes_[i];
+        if (Node* node = nodes_[i])
+        {
+            NodeTransform newTransform;
+            newTransform.Define(*node);
+            if (newTransform != initialTransforms_[i])
+                command->AddNode(node->GetID(), initialTransforms_[i], newTransform);
+        }
+    }
+
+    if (command->IsEmpty())
+        return;
 
-        NodeTransform newTransform;
-        newTransform.Define(*node);
+    // Drag is a separate undo step, neither previous nor next nudges join it
+    if (!mergeable)
+        undoStack_->BreakMerge();
+    undoStack_->Push(command, false);
+    if (!mergeable)
+        undoStack_->BreakMerge();
+}
 
-        auto command = MakeShared<SelectionTransformChanged>(context_, scene_, node->GetID(), initialTransforms_[i], newTransform);
-        commandGroup->Push(command);
+void SelectionTransform::UpdateLocalTransforms()
+{
+    const unsigned numNodes = nodes_.Size();
+    WorkQueue* workQueue = GetSubsystem<WorkQueue>();
+    const unsigned numThreads = workQueue ? workQueue->GetNumThreads() + 1 : 1;
+    if (numNodes < minNodesForThreading_ || numThreads == 1)
+    {
+        WorkItem item;
+        item.aux_ = this;
+        item.start_ = reinterpret_cast<void*>(static_cast<size_t>(0));
+        item.end_ = reinterpret_cast<void*>(static_cast<size_t>(numNodes));
+        ComputeLocalTransformsWork(&item, 0);
+        return;
     }
-    undoStack_->Push(commandGroup);
 
-    nodes_.Clear();
-    initialTransforms_.Clear();
+    // Nodes are independent because they are roots of disjoint subtrees
+    const unsigned nodesPerItem = (numNodes + numThreads - 1) / numThreads;
+    for (unsigned begin = 0; begin < numNodes; begin += nodesPerItem)
+    {
+        SharedPtr<WorkItem> item = workQueue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = ComputeLocalTransformsWork;
+        item->aux_ = this;
+        item->start_ = reinterpret_cast<void*>(static_cast<size_t>(begin));
+        item->end_ = reinterpret_cast<void*>(static_cast<size_t>(Min(begin + nodesPerItem, numNodes)));
+        workQueue->AddWorkItem(item);
+    }
+    workQueue->Complete(M_MAX_UNSIGNED);
+}
+
+void SelectionTransform::ApplyLocalTransforms()
+{
+    for (unsigned i = 0; i < nodes_.Size(); ++i)
+    {
+        if (Node* node = nodes_[i])
+            node->SetTransform(localPositions_[i], localRotations_[i]);
+    }
+}
+
+void SelectionTransform::ComputeLocalTransformsWork(const WorkItem* item, unsigned /*threadIndex*/)
+{
+    SelectionTransform* self = static_cast<SelectionTransform*>(item->aux_);
+    const unsigned begin = static_cast<unsigned>(reinterpret_cast<size_t>(item->start_));
+    const unsigned end = static_cast<unsigned>(reinterpret_cast<size_t>(item->end_));
+    for (unsigned i = begin; i < end; ++i)
+    {
+        self->localPositions_[i] = self->parentInverseTransforms_[i] * self->worldPositions_[i];
+        self->localRotations_[i] = self->parentInverseRotations_[i] * self->worldRotations_[i];
+    }
 }
 
 //////////////////////////////////////////////////////////////////////////
-SelectionTransformChanged::SelectionTransformChanged(Context* context, Scene* scene, unsigned nodeId,
-    const NodeTransform& oldTransform, const NodeTransform& newTransform)
+SelectionTransformChanged::SelectionTransformChanged(Context* context, Scene* scene, unsigned transformKinds)
     : UndoCommand(context)
     , scene_(scene)
-    , nodeId_(nodeId)
-    , oldTransform_(oldTransform)
-    , newTransform_(newTransform)
+    , transformKinds_(transformKinds)
+    , mergeKey_(transformKinds)
+{
+}
+
+void SelectionTransformChanged::Reserve(unsigned numNodes)
 {
+    nodeIds_.Reserve(numNodes);
+    oldTransforms_.Reserve(numNodes);
+    newTransforms_.Reserve(numNodes);
+}
+
+void SelectionTransformChanged::AddNode(unsigned nodeId, const NodeTransform& oldTransform, const NodeTransform& newTransform)
+{
+    mergeKey_ = mergeKey_ * 31 + nodeId;
+    nodeIds_.Push(nodeId);
+    oldTransforms_.Push(oldTransform);
+    newTransforms_.Push(newTransform);
 }
 
 void SelectionTransformChanged::Undo() const
 {
-    if (scene_)
-    {
-        if (Node* node = scene_->GetNode(nodeId_))
-            oldTransform_.Apply(*node);
-    }
+    ApplyTransforms(oldTransforms_);
 }
 
 void SelectionTransformChanged::Redo() const
 {
-    if (scene_)
+    ApplyTransforms(newTransforms_);
+}
+
+unsigned SelectionTransformChanged::GetMemoryUse() const
+{
+    return sizeof(SelectionTransformChanged) + nodeIds_.Capacity() * sizeof(unsigned)
+        + (oldTransforms_.Capacity() + newTransforms_.Capacity()) * sizeof(NodeTransform);
+}
+
+bool SelectionTransformChanged::MergeWith(const UndoCommand& other)
+{
+    const auto* next = dynamic_cast<const SelectionTransformChanged*>(&other);
+    if (!next || next->mergeKey_ != mergeKey_ || next->transformKinds_ != transformKinds_
+        || next->scene_ != scene_ || next->nodeIds_ != nodeIds_)
+        return false;
+
+    newTransforms_ = next->newTransforms_;
+    return true;
+}
+
+void SelectionTransformChanged::ApplyTransforms(const PODVector<NodeTransform>& transforms) const
+{
+    if (!scene_)
+        return;
+
+    for (unsigned i = 0; i < nodeIds_.Size(); ++i)
     {
-        if (Node* node = scene_->GetNode(nodeId_))
-            newTransform_.Apply(*node);
+        if (Node* node = scene_->GetNode(nodeIds_[i]))
+            transforms[i].Apply(*node);
     }
 }
 
@@ -2,6 +2,7 @@
 
 #include "UndoStack.h"
 #include "Selection.h" // #TODO Hide it
+#include <Urho3D/Math/Matrix3x4.h>
 #include <Urho3D/Math/Vector3.h>
 #include <Urho3D/Math/Quaternion.h>
 
@@ -34,8 +35,8 @@ public:
     virtual void ApplyScaleChange(const Vector3& delta) = 0;
     /// Snap scale values to grid.
     virtual void SnapScale(float step) = 0;
-    /// End transformation.
-    virtual void EndTransformation() = 0;
+    /// End transformation. Mergeable transformation, e.g. keyboard nudge, may join previous one of the same nodes.
+    virtual void EndTransformation(bool mergeable) = 0;
 
 };
 
@@ -48,6 +49,18 @@ namespace Urho3D
 
 class Selection;
 class Node;
+struct WorkItem;
+
+/// Kind of node transform change. Values are flags.
+enum NodeTransformKind
+{
+    /// Position changed.
+    NTK_POSITION = 1 << 0,
+    /// Rotation changed.
+    NTK_ROTATION = 1 << 1,
+    /// Scale changed.
+    NTK_SCALE = 1 << 2
+};
 
 /// Transform of the node.
 struct NodeTransform
@@ -56,6 +69,13 @@ struct NodeTransform
     void Define(const Node& node);
     /// Apply to node.
     void Apply(Node& node) const;
+    /// Test for equality with another transform.
+    bool operator ==(const NodeTransform& rhs) const
+    {
+        return position_ == rhs.position_ && rotation_ == rhs.rotation_ && scale_ == rhs.scale_;
+    }
+    /// Test for inequality with another transform.
+    bool operator !=(const NodeTransform& rhs) const { return !(*this == rhs); }
 
     /// Position.
     Vector3 position_;
@@ -98,34 +118,85 @@ public:
     /// \see Transformable::SnapScale
     void SnapScale(float step) override;
     /// \see Transformable::EndTransformation
-    void EndTransformation() override;
+    void EndTransformation(bool mergeable) override;
+    /// Set minimal number of nodes to compute transforms on worker threads.
+    void SetMinNodesForThreading(unsigned minNodes) { minNodesForThreading_ = minNodes; }
+
+private:
+    /// Push undo command with transform changes of transformed nodes. Separate gestures are not merged.
+    void PushUndoCommand(bool mergeable);
+    /// Compute local transforms of transformed nodes from world transforms.
+    void UpdateLocalTransforms();
+    /// Apply local transforms to nodes.
+    void ApplyLocalTransforms();
+    /// Compute local transforms of work item range.
+    static void ComputeLocalTransformsWork(const WorkItem* item, unsigned threadIndex);
 
 private:
     SharedPtr<UndoStack> undoStack_;
     WeakPtr<Scene> scene_;
     WeakPtr<Selection> selection_;
+    /// Transformed nodes. Nodes whose ancestors are selected are excluded, they follow their ancestors.
     Vector<WeakPtr<Node>> nodes_;
     Vector<NodeTransform> initialTransforms_;
+    /// Minimal number of nodes to compute transforms on worker threads.
+    unsigned minNodesForThreading_ = 256;
+    /// Transformation pivot, cached on transformation start.
+    Vector3 pivot_;
+    /// Kinds of applied changes since transformation start.
+    unsigned transformKinds_ = 0;
+    /// World positions of transformed nodes.
+    PODVector<Vector3> worldPositions_;
+    /// World rotations of transformed nodes.
+    PODVector<Quaternion> worldRotations_;
+    /// Inverse world transforms of parents of transformed nodes.
+    PODVector<Matrix3x4> parentInverseTransforms_;
+    /// Inverse world rotations of parents of transformed nodes.
+    PODVector<Quaternion> parentInverseRotations_;
+    /// Computed local positions of transformed nodes.
+    PODVector<Vector3> localPositions_;
+    /// Computed local rotations of transformed nodes.
+    PODVector<Quaternion> localRotations_;
 };
 
 // #TODO Move it
-/// Node transform edited.
+/// Transforms of multiple nodes edited.
 class SelectionTransformChanged : public UndoCommand
 {
 public:
+    /// Merge ID.
+    static const int MERGE_ID = 2;
+
     /// Construct.
-    SelectionTransformChanged(Context* context, Scene* scene, unsigned nodeId,
-        const NodeTransform& oldTransform, const NodeTransform& newTransform);
+    SelectionTransformChanged(Context* context, Scene* scene, unsigned transformKinds);
+    /// Reserve space for nodes.
+    void Reserve(unsigned numNodes);
+    /// Add node transform change.
+    void AddNode(unsigned nodeId, const NodeTransform& oldTransform, const NodeTransform& newTransform);
+    /// Return whether there are no changes.
+    bool IsEmpty() const { return nodeIds_.Empty(); }
 
     void Undo() const override;
     void Redo() const override;
-    String GetTitle() override { return "Node Transform"; }
+    String GetTitle() override { return "Node Transforms"; }
+    unsigned GetMemoryUse() const override;
+    int GetMergeId() const override { return MERGE_ID; }
+    /// Merge following change of the same kind applied to the same nodes, e.g. repeated keyboard nudges.
+    bool MergeWith(const UndoCommand& other) override;
+
+private:
+    /// Apply transforms to nodes.
+    void ApplyTransforms(const PODVector<NodeTransform>& transforms) const;
 
 private:
     WeakPtr<Scene> scene_;
-    unsigned nodeId_;
-    NodeTransform oldTransform_;
-    NodeTransform newTransform_;
+    /// Kinds of transform changes.
+    unsigned transformKinds_ = 0;
+    /// Hash of transform kinds and node IDs, used to reject merge quickly.
+    unsigned mergeKey_ = 0;
+    PODVector<unsigned> nodeIds_;
+    PODVector<NodeTransform> oldTransforms_;
+    PODVector<NodeTransform> newTransforms_;
 };
 
 }
@@ -3,15 +3,46 @@
 namespace Urho3D
 {
 
-void UndoStack::Push(const UndoCommandSPtr& command, bool redo /*= true*/)
+void UndoStack::SetLimit(unsigned limit)
 {
-    if (undoStack_.Size() >= limit_)
-        undoStack_.Erase(0, undoStack_.Size() - limit_ + 1);
+    limit_ = limit;
+    EvictUndo();
+}
 
-    undoStack_.Push(command);
-    redoStack_.Clear();
+void UndoStack::SetMemoryLimit(unsigned memoryLimit)
+{
+    memoryLimit_ = memoryLimit;
+    EvictUndo();
+}
+
+void UndoStack::Push(const UndoCommandSPtr& command, bool redo /*= true*/)
+{
+    ClearRedo();
     if (redo)
         command->Redo();
+
+    // Try to merge into the last command
+    const bool mergeBarrier = mergeBarrier_;
+    mergeBarrier_ = false;
+    if (!mergeBarrier && numUndo_ > 0 && command->GetMergeId() >= 0)
+    {
+        Entry& lastEntry = GetUndoEntry(numUndo_ - 1);
+        if (lastEntry.command_->GetMergeId() == command->GetMergeId() && lastEntry.command_->MergeWith(*command))
+        {
+            memoryUse_ -= lastEntry.memoryUse_;
+            lastEntry.memoryUse_ = lastEntry.command_->GetMemoryUse();
+            memoryUse_ += lastEntry.memoryUse_;
+            EvictUndo();
+            return;
+        }
+    }
+
+    Entry entry;
+    entry.command_ = command;
+    entry.memoryUse_ = command->GetMemoryUse();
+    memoryUse_ += entry.memoryUse_;
+    PushUndo(entry);
+    EvictUndo();
 }
 
 bool UndoStack::Undo()
@@ -19,10 +50,11 @@ bool UndoStack::Undo()
     if (!CanUndo())
         return false;
 
-    UndoCommandSPtr command = undoStack_.Back();
-    undoStack_.Pop();
-    command->Undo();
-    redoStack_.Push(command);
+    Entry entry = PopUndo();
+    entry.command_->Undo();
+    mergeBarrier_ = true;
+    redoStack_.Push(entry);
+    redoMemoryUse_ += entry.memoryUse_;
 
     return true;
 }
@@ -32,17 +64,19 @@ bool UndoStack::Redo()
     if (!CanRedo())
         return false;
 
-    UndoCommandSPtr command = redoStack_.Back();
+    Entry entry = redoStack_.Back();
     redoStack_.Pop();
-    command->Redo();
-    undoStack_.Push(command);
+    redoMemoryUse_ -= entry.memoryUse_;
+    entry.command_->Redo();
+    PushUndo(entry);
+    mergeBarrier_ = true;
 
     return true;
 }
 
 bool UndoStack::CanUndo() const
 {
-    return !undoStack_.Empty();
+    return numUndo_ > 0;
 }
 
 bool UndoStack::CanRedo() const
@@ -52,12 +86,69 @@ bool UndoStack::CanRedo() const
 
 String UndoStack::GetUndoTitle() const
 {
-    return CanUndo() ? undoStack_.Back()->GetTitle() : String::EMPTY;
+    return CanUndo() ? GetUndoEntry(numUndo_ - 1).command_->GetTitle() : String::EMPTY;
 }
 
 String UndoStack::GetRedoTitle() const
 {
-    return CanRedo() ? redoStack_.Back()->GetTitle() : String::EMPTY;
+    return CanRedo() ? redoStack_.Back().command_->GetTitle() : String::EMPTY;
+}
+
+UndoStackStats UndoStack::GetStats() const
+{
+    UndoStackStats stats;
+    stats.numUndoCommands_ = numUndo_;
+    stats.numRedoCommands_ = redoStack_.Size();
+    stats.memoryUse_ = memoryUse_;
+    stats.memoryLimit_ = memoryLimit_;
+    stats.numEvictedCommands_ = numEvicted_;
+    return stats;
+}
+
+void UndoStack::PushUndo(Entry entry)
+{
+    // Grow ring buffer and make it linear again
+    if (numUndo_ == undoRing_.Size())
+    {
+        Vector<Entry> ring(Max(8u, undoRing_.Size() * 2));
+        for (unsigned i = 0; i < numUndo_; ++i)
+            ring[i] = GetUndoEntry(i);
+        undoRing_.Swap(ring);
+        undoFirst_ = 0;
+    }
+
+    GetUndoEntry(numUndo_) = entry;
+    ++numUndo_;
+}
+
+UndoStack::Entry UndoStack::PopUndo()
+{
+    Entry& slot = GetUndoEntry(numUndo_ - 1);
+    Entry entry = slot;
+    slot = Entry();
+    --numUndo_;
+    return entry;
+}
+
+void UndoStack::EvictUndo()
+{
+    // Keep the last command regardless of memory limit. Eviction can't free memory of redo commands
+    while (numUndo_ > limit_ || (numUndo_ > 1 && memoryUse_ - redoMemoryUse_ > memoryLimit_))
+    {
+        Entry& slot = GetUndoEntry(0);
+        memoryUse_ -= slot.memoryUse_;
+        slot = Entry();
+        undoFirst_ = (undoFirst_ + 1) % undoRing_.Size();
+        --numUndo_;
+        ++numEvicted_;
+    }
+}
+
+void UndoStack::ClearRedo()
+{
+    memoryUse_ -= redoMemoryUse_;
+    redoMemoryUse_ = 0;
+    redoStack_.Clear();
 }
 
 }
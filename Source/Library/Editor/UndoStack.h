@@ -14,6 +14,12 @@ public:
     virtual void Undo() const = 0;
     virtual void Redo() const = 0;
     virtual String GetTitle() { return String::EMPTY; }
+    /// Return approximate memory used by command in bytes.
+    virtual unsigned GetMemoryUse() const { return sizeof(UndoCommand); }
+    /// Return merge ID. Only commands with the same non-negative ID are merged.
+    virtual int GetMergeId() const { return -1; }
+    /// Merge following command into this one. Return false if commands are incompatible.
+    virtual bool MergeWith(const UndoCommand& /*other*/) { return false; }
 
 };
 
@@ -36,6 +42,13 @@ public:
             command->Redo();
     }
     String GetTitle() override { return title_; }
+    unsigned GetMemoryUse() const override
+    {
+        unsigned memoryUse = sizeof(UndoCommandGroup) + title_.Capacity() + commands_.Capacity() * sizeof(UndoCommandSPtr);
+        for (UndoCommand* command : commands_)
+            memoryUse += command->GetMemoryUse();
+        return memoryUse;
+    }
 
     void Push(const UndoCommandSPtr& command) { commands_.Push(command); }
 
@@ -44,25 +57,86 @@ private:
     Vector<SharedPtr<UndoCommand>> commands_;
 };
 
+/// Undo stack statistics.
+struct UndoStackStats
+{
+    /// Number of commands that can be undone.
+    unsigned numUndoCommands_ = 0;
+    /// Number of commands that can be redone.
+    unsigned numRedoCommands_ = 0;
+    /// Memory used by all commands in bytes.
+    unsigned memoryUse_ = 0;
+    /// Memory limit in bytes.
+    unsigned memoryLimit_ = 0;
+    /// Number of commands evicted since creation.
+    unsigned numEvictedCommands_ = 0;
+};
+
 class UndoStack : public Object
 {
     URHO3D_OBJECT(UndoStack, Object);
 
 public:
     UndoStack(Context* context) : Object(context) { }
-    void SetLimit(unsigned limit) { limit_ = limit; }
+    /// Set max number of commands that can be undone.
+    void SetLimit(unsigned limit);
+    /// Set max memory used by undo commands in bytes. The last command is kept even if it exceeds the limit.
+    /// Redo commands can't be evicted and aren't counted.
+    void SetMemoryLimit(unsigned memoryLimit);
+    /// Push command. Command may be merged into the last one.
     void Push(const UndoCommandSPtr& command, bool redo = true);
+    /// Prevent next pushed command from merging into the last one.
+    void BreakMerge() { mergeBarrier_ = true; }
     bool Undo();
     bool Redo();
     bool CanUndo() const;
     bool CanRedo() const;
     String GetUndoTitle() const;
     String GetRedoTitle() const;
+    /// Return statistics.
+    UndoStackStats GetStats() const;
+
+private:
+    /// Command with cached memory use.
+    struct Entry
+    {
+        /// Command.
+        UndoCommandSPtr command_;
+        /// Memory used by command.
+        unsigned memoryUse_ = 0;
+    };
+
+    /// Return undo entry by index from the oldest one.
+    Entry& GetUndoEntry(unsigned index) { return undoRing_[(undoFirst_ + index) % undoRing_.Size()]; }
+    /// Return undo entry by index from the oldest one.
+    const Entry& GetUndoEntry(unsigned index) const { return undoRing_[(undoFirst_ + index) % undoRing_.Size()]; }
+    /// Push undo entry.
+    void PushUndo(Entry entry);
+    /// Pop newest undo entry.
+    Entry PopUndo();
+    /// Evict oldest undo entries until limits are satisfied.
+    void EvictUndo();
+    /// Clear redo stack.
+    void ClearRedo();
 
 private:
-    unsigned limit_ = 50;
-    Vector<UndoCommandSPtr> undoStack_;
-    Vector<UndoCommandSPtr> redoStack_;
+    unsigned limit_ = M_MAX_UNSIGNED;
+    unsigned memoryLimit_ = 64 * 1024 * 1024;
+    /// Ring buffer of undo entries.
+    Vector<Entry> undoRing_;
+    /// Index of the oldest undo entry in ring buffer.
+    unsigned undoFirst_ = 0;
+    /// Number of undo entries.
+    unsigned numUndo_ = 0;
+    Vector<Entry> redoStack_;
+    /// Memory used by undo and redo commands.
+    unsigned memoryUse_ = 0;
+    /// Memory used by redo commands.
+    unsigned redoMemoryUse_ = 0;
+    /// Number of evicted commands.
+    unsigned numEvicted_ = 0;
+    /// Whether the last command is closed for merging.
+    bool mergeBarrier_ = false;
 };
 
 }
@@ -0,0 +1,127 @@
+#include "../../Library/Editor/IdBufferPicker.h"
+
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Engine/Application.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Drawable.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/OctreeQuery.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Compares octree raycast and ID buffer picking used by ObjectSelector on big scenes.
+class PickingBenchmarkApplication : public Application
+{
+    URHO3D_OBJECT(PickingBenchmarkApplication, Application);
+
+public:
+    PickingBenchmarkApplication(Context* context) : Application(context) { }
+
+    virtual void Setup() override
+    {
+        engineParameters_[EP_HEADLESS] = true;
+        engineParameters_[EP_LOG_NAME] = "02_PickingBenchmark.log";
+    }
+
+    virtual void Start() override
+    {
+        RunBenchmark(10000);
+        RunBenchmark(100000);
+        engine_->Exit();
+    }
+
+private:
+    void RunBenchmark(unsigned numDrawables)
+    {
+        static const IntRect viewportRect(0, 0, 1280, 720);
+        static const unsigned numPicks = 1000;
+        static const unsigned numCameraMoves = 10;
+
+        ResourceCache* cache = GetSubsystem<ResourceCache>();
+        Model* model = cache->GetResource<Model>("Models/Box.mdl");
+
+        // Fill square grid with boxes
+        auto scene = MakeShared<Scene>(context_);
+        Octree* octree = scene->CreateComponent<Octree>();
+        const unsigned gridSize = static_cast<unsigned>(Ceil(Sqrt(static_cast<float>(numDrawables))));
+        octree->SetSize(BoundingBox(Vector3(-1.0f, -1.0f, -1.0f) * static_cast<float>(gridSize), Vector3::ONE * static_cast<float>(gridSize)), 8);
+        for (unsigned i = 0; i < numDrawables; ++i)
+        {
+            Node* node = scene->CreateChild();
+            node->SetPosition(Vector3(static_cast<float>(i % gridSize) * 2.0f - gridSize, 0.0f, static_cast<float>(i / gridSize) * 2.0f - gridSize));
+            StaticModel* staticModel = node->CreateComponent<StaticModel>();
+            staticModel->SetModel(model);
+        }
+
+        Node* cameraNode = scene->CreateChild("Camera");
+        Camera* camera = cameraNode->CreateComponent<Camera>();
+        camera->SetAspectRatio(static_cast<float>(viewportRect.Width()) / viewportRect.Height());
+        camera->SetFarClip(static_cast<float>(gridSize) * 4.0f);
+        cameraNode->SetPosition(Vector3(0.0f, static_cast<float>(gridSize) * 0.5f, -static_cast<float>(gridSize)));
+        cameraNode->LookAt(Vector3::ZERO);
+
+        // Octree is not updated by renderer in headless mode
+        FrameInfo frameInfo;
+        frameInfo.camera_ = camera;
+        frameInfo.viewSize_ = viewportRect.Size();
+        octree->Update(frameInfo);
+
+        // Same mouse positions for both methods
+        PODVector<IntVector2> mousePositions;
+        SetRandomSeed(1);
+        for (unsigned i = 0; i < numPicks; ++i)
+            mousePositions.Push(IntVector2(Random(viewportRect.Width()), Random(viewportRect.Height())));
+
+        // Hover picking via raycast
+        HiresTimer timer;
+        unsigned numRaycastHits = 0;
+        for (const IntVector2& mousePosition : mousePositions)
+        {
+            const Ray ray = camera->GetScreenRay(
+                static_cast<float>(mousePosition.x_) / viewportRect.Width(),
+                static_cast<float>(mousePosition.y_) / viewportRect.Height());
+            PODVector<RayQueryResult> result;
+            RayOctreeQuery query(result, ray, RAY_TRIANGLE, camera->GetFarClip(), DRAWABLE_GEOMETRY, 0x7fffffff);
+            octree->RaycastSingle(query);
+            if (!result.Empty())
+                ++numRaycastHits;
+        }
+        const long long raycastTime = timer.GetUSec(true);
+
+        // Hover picking via ID buffer, buffer is built once
+        auto picker = MakeShared<IdBufferPicker>(context_);
+        picker->Update(octree, camera, viewportRect, DRAWABLE_GEOMETRY, 0);
+        const long long buildTime = timer.GetUSec(true);
+        unsigned numIdBufferHits = 0;
+        for (const IntVector2& mousePosition : mousePositions)
+        {
+            if (picker->GetDrawable(mousePosition))
+                ++numIdBufferHits;
+        }
+        const long long lookupTime = timer.GetUSec(true);
+
+        // Moving camera forces buffer rebuild
+        for (unsigned i = 0; i < numCameraMoves; ++i)
+        {
+            cameraNode->Translate(Vector3::RIGHT * 0.1f, TS_WORLD);
+            picker->Update(octree, camera, viewportRect, DRAWABLE_GEOMETRY, 0);
+        }
+        const long long rebuildTime = timer.GetUSec(true) / numCameraMoves;
+
+        URHO3D_LOGINFOF("%u drawables, %u picks: raycast %.3f ms (%u hits); ID buffer build %.3f ms, lookup %.3f ms (%u hits), "
+            "rebuild on camera move %.3f ms",
+            numDrawables, numPicks, raycastTime / 1000.0, numRaycastHits, buildTime / 1000.0, lookupTime / 1000.0, numIdBufferHits,
+            rebuildTime / 1000.0);
+    }
+};
+
+URHO3D_DEFINE_APPLICATION_MAIN(PickingBenchmarkApplication)
@@ -0,0 +1,111 @@
+#include "../../Urho3DEditor/SceneEditor/SceneActions.h"
+
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Engine/Application.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Compares XML and binary snapshot undo payloads used by node deletion actions.
+class UndoSnapshotBenchmarkApplication : public Application
+{
+    URHO3D_OBJECT(UndoSnapshotBenchmarkApplication, Application);
+
+public:
+    UndoSnapshotBenchmarkApplication(Context* context) : Application(context) { }
+
+    virtual void Setup() override
+    {
+        engineParameters_[EP_HEADLESS] = true;
+        engineParameters_[EP_LOG_NAME] = "03_UndoSnapshotBenchmark.log";
+    }
+
+    virtual void Start() override
+    {
+        static const unsigned numNodes = 10000;
+
+        auto scene = MakeShared<Scene>(context_);
+        scene->CreateComponent<Octree>();
+        Node* subtree = CreateSubtree(scene, numNodes);
+        const unsigned subtreeId = subtree->GetID();
+
+        // XML path, as deletion actions did before
+        HiresTimer timer;
+        auto xml = MakeShared<XMLFile>(context_);
+        subtree->SaveXML(xml->CreateRoot("node"));
+        const long long xmlSaveTime = timer.GetUSec(true);
+        const unsigned xmlSize = xml->ToString().Length();
+        const long long xmlLoadTime = MeasureRestore(scene, subtreeId,
+            [&](Node& node) { return node.LoadXML(xml->GetRoot()); });
+        xml.Reset();
+
+        // Binary snapshots, plain and compressed
+        Urho3DEditor::NodeSnapshot::SetCompressionThreshold(M_MAX_UNSIGNED);
+        RunSnapshotBenchmark(scene, subtreeId, "Binary", xmlSaveTime, xmlLoadTime, xmlSize);
+        Urho3DEditor::NodeSnapshot::SetCompressionThreshold(0);
+        RunSnapshotBenchmark(scene, subtreeId, "Compressed binary", xmlSaveTime, xmlLoadTime, xmlSize);
+
+        Urho3DEditor::NodeSnapshot::ClearBufferPool();
+        engine_->Exit();
+    }
+
+private:
+    /// Create node with given number of descendants, grouped in nodes of 100.
+    Node* CreateSubtree(Scene* scene, unsigned numNodes)
+    {
+        ResourceCache* cache = GetSubsystem<ResourceCache>();
+        Model* model = cache->GetResource<Model>("Models/Box.mdl");
+
+        Node* root = scene->CreateChild("Subtree");
+        Node* group = nullptr;
+        for (unsigned i = 0; i < numNodes; ++i)
+        {
+            if (i % 100 == 0)
+                group = root->CreateChild("Group");
+            Node* node = group->CreateChild("Box");
+            node->SetPosition(Vector3(static_cast<float>(i % 100), 0.0f, static_cast<float>(i / 100)));
+            StaticModel* staticModel = node->CreateComponent<StaticModel>();
+            staticModel->SetModel(model);
+        }
+        return root;
+    }
+
+    /// Remove subtree and restore it with given loader, like undo of deletion does. Return time in microseconds.
+    template <class T> long long MeasureRestore(Scene* scene, unsigned subtreeId, T loader)
+    {
+        scene->RemoveChild(scene->GetNode(subtreeId));
+
+        HiresTimer timer;
+        Node* node = scene->CreateChild("", REPLICATED, subtreeId);
+        loader(*node);
+        return timer.GetUSec(false);
+    }
+
+    void RunSnapshotBenchmark(Scene* scene, unsigned subtreeId, const char* name,
+        long long xmlSaveTime, long long xmlLoadTime, unsigned xmlSize)
+    {
+        HiresTimer timer;
+        Urho3DEditor::NodeSnapshot snapshot;
+        snapshot.Save(*scene->GetNode(subtreeId));
+        const long long saveTime = timer.GetUSec(false);
+        const long long loadTime = MeasureRestore(scene, subtreeId,
+            [&](Node& node) { return snapshot.Load(node); });
+
+        URHO3D_LOGINFOF("%s snapshot of %u nodes: save %.3f ms, restore %.3f ms, %u bytes; "
+            "XML: save %.3f ms, restore %.3f ms, %u bytes",
+            name, scene->GetNode(subtreeId)->GetNumChildren(true), saveTime / 1000.0, loadTime / 1000.0, snapshot.GetDataSize(),
+            xmlSaveTime / 1000.0, xmlLoadTime / 1000.0, xmlSize);
+    }
+};
+
+URHO3D_DEFINE_APPLICATION_MAIN(UndoSnapshotBenchmarkApplication)
@@ -12,6 +12,7 @@
 #include "Documents/ProjectDocument.h"
 #include "SceneEditor/AttributeInspector.h"
 #include "SceneEditor/HierarchyWindow.h"
+#include "SceneEditor/SceneActions.h"
 #include "SceneEditor/SceneEditor.h"
 #include "SceneEditor/SceneDocument.h"
 
@@ -33,7 +34,9 @@ int Application::Run()
 {
     if (!Initialize())
         return 1;
-    return exec();
+    const int result = exec();
+    NodeSnapshot::ClearBufferPool();
+    return result;
 }
 
 bool Application::Initialize()
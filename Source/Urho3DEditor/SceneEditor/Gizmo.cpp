@@ -213,7 +213,7 @@ void Gizmo::PrepareUndo()
     // Store initial transforms for undo when gizmo drag started
     if (IsDragging() && !WasDragging())
     {
-        editNodes_ = document_.GetSelectedNodesAndComponents().toList();
+        editNodes_ = document_.GetSelectedTopmostNodes().toList();
         oldTransforms_.resize(editNodes_.size());
         for (int i = 0; i < editNodes_.size(); ++i)
             oldTransforms_[i].Define(*editNodes_[i]);
@@ -483,7 +483,7 @@ bool Gizmo::UseGizmoMouse(const Urho3D::Ray& mouseRay)
         // Store initial transforms for undo when gizmo drag started
         if (!lastMouseDrag_)
         {
-            editNodes_ = document_.GetSelectedNodesAndComponents().toList();
+            editNodes_ = document_.GetSelectedTopmostNodes().toList();
             oldTransforms_.resize(editNodes_.size());
             for (int i = 0; i < editNodes_.size(); ++i)
                 oldTransforms_[i].Define(*editNodes_[i]);
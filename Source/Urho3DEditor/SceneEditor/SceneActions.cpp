@@ -1,11 +1,134 @@
 #include "SceneActions.h"
 #include "SceneDocument.h"
+#include <Urho3D/IO/Compression.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
 #include <Urho3D/Scene/Node.h>
 #include <Urho3D/Scene/Scene.h>
 
 namespace Urho3DEditor
 {
 
+namespace
+{
+
+/// Max number of recycled snapshot buffers.
+const int MAX_POOLED_SNAPSHOT_BUFFERS = 32;
+
+/// Max capacity in bytes of recycled snapshot buffer. Bigger buffers are freed.
+const unsigned MAX_POOLED_SNAPSHOT_BUFFER_CAPACITY = 256 * 1024;
+
+/// Pool of recycled snapshot buffers. Buffers are freed on shutdown.
+struct SnapshotBufferPool
+{
+    /// Destruct.
+    ~SnapshotBufferPool() { Clear(); }
+    /// Free all buffers.
+    void Clear()
+    {
+        qDeleteAll(buffers_);
+        buffers_.clear();
+    }
+
+    /// Buffers.
+    QVector<Urho3D::VectorBuffer*> buffers_;
+};
+
+/// Get pool of recycled snapshot buffers.
+SnapshotBufferPool& GetSnapshotBufferPool()
+{
+    static SnapshotBufferPool pool;
+    return pool;
+}
+
+/// Allocate empty snapshot buffer.
+Urho3D::VectorBuffer* AllocateSnapshotBuffer()
+{
+    QVector<Urho3D::VectorBuffer*>& buffers = GetSnapshotBufferPool().buffers_;
+    if (buffers.isEmpty())
+        return new Urho3D::VectorBuffer();
+
+    Urho3D::VectorBuffer* buffer = buffers.takeLast();
+    buffer->Clear();
+    return buffer;
+}
+
+/// Release snapshot buffer. Big buffers are not recycled, so the pool doesn't hold peak memory.
+void ReleaseSnapshotBuffer(Urho3D::VectorBuffer* buffer)
+{
+    QVector<Urho3D::VectorBuffer*>& buffers = GetSnapshotBufferPool().buffers_;
+    if (buffers.size() < MAX_POOLED_SNAPSHOT_BUFFERS && buffer->GetBuffer().Capacity() <= MAX_POOLED_SNAPSHOT_BUFFER_CAPACITY)
+        buffers.push_back(buffer);
+    else
+        delete buffer;
+}
+
+}
+
+unsigned NodeSnapshot::compressionThreshold_ = 64 * 1024;
+
+NodeSnapshot::~NodeSnapshot()
+{
+    Reset();
+}
+
+void NodeSnapshot::ClearBufferPool()
+{
+    GetSnapshotBufferPool().Clear();
+}
+
+void NodeSnapshot::Save(const Urho3D::Node& node)
+{
+    Reset();
+    buffer_ = AllocateSnapshotBuffer();
+    node.Save(*buffer_);
+
+    compressed_ = buffer_->GetSize() >= compressionThreshold_;
+    if (compressed_)
+    {
+        Urho3D::VectorBuffer* compressedBuffer = AllocateSnapshotBuffer();
+        buffer_->Seek(0);
+        Urho3D::CompressStream(*compressedBuffer, *buffer_);
+        ReleaseSnapshotBuffer(buffer_);
+        buffer_ = compressedBuffer;
+    }
+}
+
+bool NodeSnapshot::Load(Urho3D::Node& node) const
+{
+    if (!buffer_)
+        return false;
+
+    Urho3D::MemoryBuffer source(buffer_->GetData(), buffer_->GetSize());
+    if (!compressed_)
+        return node.Load(source);
+
+    Urho3D::VectorBuffer* decompressed = AllocateSnapshotBuffer();
+    bool success = Urho3D::DecompressStream(*decompressed, source);
+    if (success)
+    {
+        decompressed->Seek(0);
+        success = node.Load(*decompressed);
+    }
+    ReleaseSnapshotBuffer(decompressed);
+    return success;
+}
+
+unsigned NodeSnapshot::GetDataSize() const
+{
+    return buffer_ ? buffer_->GetSize() : 0;
+}
+
+void NodeSnapshot::Reset()
+{
+    if (buffer_)
+    {
+        ReleaseSnapshotBuffer(buffer_);
+        buffer_ = nullptr;
+    }
+    compressed_ = false;
+}
+
 void NodeTransform::Define(const Urho3D::Node& node)
 {
     position_ = node.GetPosition();
@@ -68,7 +191,11 @@ void CreateNodeAction::undo()
     Node* parent = scene.GetNode(parentId_);
     Node* node = scene.GetNode(nodeId_);
     if (parent && node)
+    {
+        // Binary snapshot is faster to load than XML
+        snapshot_.Save(*node);
         parent->RemoveChild(node);
+    }
 }
 
 void CreateNodeAction::redo()
@@ -80,7 +207,10 @@ void CreateNodeAction::redo()
     if (parent)
     {
         Node* node = parent->CreateChild("", nodeId_ < FIRST_LOCAL_ID ? REPLICATED : LOCAL, nodeId_);
-        node->LoadXML(desc_->GetRoot());
+        if (snapshot_.IsEmpty())
+            node->LoadXML(desc_->GetRoot());
+        else
+            snapshot_.Load(*node);
         /// \todo Do we need focusing?
         //FocusNode(node);
     }
@@ -92,11 +222,9 @@ DeleteNodeAction::DeleteNodeAction(SceneDocument& document, Urho3D::Node& node,
     , document_(document)
     , nodeId_(node.GetID())
     , parentId_(node.GetParent()->GetID())
-    , nodeData_(new Urho3D::XMLFile(document.GetContext()))
     , index_(node.GetParent()->GetChildren().IndexOf(Urho3D::SharedPtr<Urho3D::Node>(&node)))
 {
-    Urho3D::XMLElement rootElem = nodeData_->CreateRoot("node");
-    node.SaveXML(rootElem);
+    nodeData_.Save(node);
 }
 
 void DeleteNodeAction::undo()
@@ -108,7 +236,7 @@ void DeleteNodeAction::undo()
     if (parent)
     {
         Node* node = parent->CreateChild("", nodeId_ < FIRST_LOCAL_ID ? REPLICATED : LOCAL, nodeId_);
-        node->LoadXML(nodeData_->GetRoot());
+        nodeData_.Load(*node);
         parent->AddChild(node, index_);
         /// \todo Do we need focusing?
         //FocusNode(node);
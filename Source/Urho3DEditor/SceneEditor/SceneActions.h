@@ -14,6 +14,7 @@ class Scene;
 class Node;
 class Component;
 class Serializable;
+class VectorBuffer;
 
 }
 
@@ -38,6 +39,44 @@ struct NodeTransform
     Urho3D::Vector3 scale_;
 };
 
+/// Compact binary snapshot of node with children. Big snapshots are compressed.
+class NodeSnapshot
+{
+public:
+    /// Construct empty.
+    NodeSnapshot() = default;
+    /// Destruct.
+    ~NodeSnapshot();
+    /// Prohibit copy.
+    NodeSnapshot(const NodeSnapshot&) = delete;
+    /// Prohibit copy.
+    NodeSnapshot& operator=(const NodeSnapshot&) = delete;
+
+    /// Set min size of snapshot in bytes that is compressed.
+    static void SetCompressionThreshold(unsigned threshold) { compressionThreshold_ = threshold; }
+    /// Free recycled snapshot buffers. The pool is also freed on shutdown.
+    static void ClearBufferPool();
+
+    /// Save node with children.
+    void Save(const Urho3D::Node& node);
+    /// Load node with children. Return false if snapshot is empty or broken.
+    bool Load(Urho3D::Node& node) const;
+    /// Release snapshot data.
+    void Reset();
+    /// Return whether the snapshot is empty.
+    bool IsEmpty() const { return !buffer_; }
+    /// Return size of snapshot data in bytes.
+    unsigned GetDataSize() const;
+
+private:
+    /// Min size of snapshot in bytes that is compressed.
+    static unsigned compressionThreshold_;
+    /// Snapshot data. Buffers are recycled between snapshots.
+    Urho3D::VectorBuffer* buffer_ = nullptr;
+    /// Whether the data is compressed.
+    bool compressed_ = false;
+};
+
 /// Node transform edited.
 class EditNodeTransformAction : public QUndoCommand
 {
@@ -87,6 +126,8 @@ private:
     uint parentId_;
     /// Node data.
     Urho3D::SharedPtr<Urho3D::XMLFile> desc_;
+    /// Node snapshot taken on undo. Used instead of node data if present.
+    NodeSnapshot snapshot_;
 
 };
 
@@ -111,7 +152,7 @@ private:
     /// Parent node ID.
     uint parentId_;
     /// Node data.
-    Urho3D::SharedPtr<Urho3D::XMLFile> nodeData_;
+    NodeSnapshot nodeData_;
     /// Node index in parent.
     unsigned index_;
 
@@ -556,6 +556,42 @@ void SceneDocument::GatherSelection()
     }
 }
 
+SceneDocument::NodeSet SceneDocument::GetSelectedTopmostNodes() const
+{
+    using namespace Urho3D;
+
+    // Whether the node is selected or has selected ancestor, shared between nodes with common ancestors
+    NodeSet result;
+    QHash<Node*, bool> coveredNodes;
+    QVector<Node*> path;
+    for (Node* node : selectedNodesAndComponents_)
+    {
+        path.clear();
+        bool covered = false;
+        for (Node* parent = node->GetParent(); parent; parent = parent->GetParent())
+        {
+            auto iter = coveredNodes.find(parent);
+            if (iter != coveredNodes.end())
+            {
+                covered = iter.value();
+                break;
+            }
+            if (selectedNodesAndComponents_.contains(parent))
+            {
+                covered = true;
+                break;
+            }
+            path.push_back(parent);
+        }
+        for (Node* pathNode : path)
+            coveredNodes.insert(pathNode, covered);
+
+        if (!covered)
+            result.insert(node);
+    }
+    return result;
+}
+
 bool SceneDocument::CheckForExistingGlobalComponent(Urho3D::Node& node, const Urho3D::String& typeName)
 {
     if (typeName != "Octree" && typeName != "PhysicsWorld" && typeName != "DebugRenderer")
@@ -97,6 +97,9 @@ public:
     const ComponentSet& GetSelectedComponents() const { return selectedComponents_; }
     /// Get selected nodes and components.
     const NodeSet& GetSelectedNodesAndComponents() const { return selectedNodesAndComponents_; }
+    /// Get top-most selected nodes and nodes of selected components. Nodes with selected ancestors are excluded.
+    /// Computed on each call, because nodes may be reparented without selection change.
+    NodeSet GetSelectedTopmostNodes() const;
     /// Returns whether there are selected nodes and/or components.
     bool HasSelectedNodesOrComponents() const { return !selectedNodesAndComponents_.empty(); }
     /// Get center point of selected nodes.